@@ -4,20 +4,16 @@
 
 #include "Components/StaticMeshComponent.h"
 #include "Engine/CollisionProfile.h"
-#include "Engine/World.h"
-#include "TimerManager.h"
 
 ADestroyedStructure::ADestroyedStructure()
 {
 	PrimaryActorTick.bStartWithTickEnabled = false;
 	SetCanBeDamaged(false);
-	InitialLifeSpan = 6.0f;
 
 	StaticMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
 	RootComponent = StaticMesh;
 	StaticMesh->bApplyImpulseOnDamage = false;
 	StaticMesh->SetGenerateOverlapEvents(false);
-	StaticMesh->SetNotifyRigidBodyCollision(true);
 	StaticMesh->SetCanEverAffectNavigation(false);
 
 	// NOTE: You can create a new collision profile and use it
@@ -26,13 +22,12 @@ ADestroyedStructure::ADestroyedStructure()
 	StaticMesh->SetCollisionResponseToChannel(ECC_Camera, ECR_Block);
 	StaticMesh->SetCollisionResponseToChannel(ECC_WorldStatic, ECR_Block);
 	StaticMesh->SetCollisionResponseToChannel(ECC_WorldDynamic, ECR_Block);
-
-	// Initialize variables
-	bDoOnceHit = true;
 }
 
-void ADestroyedStructure::Initialize(UStaticMesh* InMesh, TArray<UMaterialInterface*> Materials, const float InLinearDamping, const float InAngularDamping) const
+void ADestroyedStructure::Initialize(UStaticMesh* InMesh, const TArray<UMaterialInterface*>& Materials, const float InLinearDamping, const float InAngularDamping, bool bSimulatePhysics) const
 {
+	// Recycled pieces may have the materials of another mesh
+	StaticMesh->EmptyOverrideMaterials();
 	StaticMesh->SetStaticMesh(InMesh);
 
 	for (int32 i = 0; i < Materials.Num(); ++i)
@@ -42,34 +37,27 @@ void ADestroyedStructure::Initialize(UStaticMesh* InMesh, TArray<UMaterialInterf
 
 	StaticMesh->SetLinearDamping(InLinearDamping);
 	StaticMesh->SetAngularDamping(InAngularDamping);
+	StaticMesh->SetVisibility(true);
 
-	StaticMesh->SetSimulatePhysics(true);
-
-	StaticMesh->OnComponentHit.AddDynamic(this, &ADestroyedStructure::MeshHit);
-}
-
-void ADestroyedStructure::MeshHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
-{
-	if (bDoOnceHit == false)
+	if (bSimulatePhysics)
 	{
-		return;
-	}
-	
-	bDoOnceHit = false;
-	StaticMesh->SetNotifyRigidBodyCollision(false);
-
-	const float Delay = GetLifeSpan() - 2.0f;
-	if (Delay > 0.0f)
-	{
-		FTimerHandle TimerHandle;
-		GetWorld()->GetTimerManager().SetTimer(TimerHandle, this, &ADestroyedStructure::StartSink, Delay);
+		StaticMesh->SetCollisionResponseToChannel(ECC_WorldStatic, ECR_Block);
+		StaticMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		StaticMesh->SetSimulatePhysics(true);
 	}
 	else
 	{
-		StartSink();
+		StaticMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	}
 }
 
+void ADestroyedStructure::Deactivate() const
+{
+	StaticMesh->SetSimulatePhysics(false);
+	StaticMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	StaticMesh->SetVisibility(false);
+}
+
 void ADestroyedStructure::StartSink() const
 {
 	StaticMesh->SetLinearDamping(1.0f);
@@ -6,6 +6,9 @@
 #include "GameFramework/Actor.h"
 #include "DestroyedStructure.generated.h"
 
+/**
+ * Debris piece of a destroyed turret, pooled and recycled by the debris subsystem
+ */
 UCLASS()
 class TURRETAI_API ADestroyedStructure : public AActor
 {
@@ -18,15 +21,15 @@ class TURRETAI_API ADestroyedStructure : public AActor
 public:
 	ADestroyedStructure();
 
-	void Initialize(UStaticMesh* InMesh, TArray<UMaterialInterface*> Materials, const float InLinearDamping, const float InAngularDamping) const;
+	/**
+	* Showing the piece with the mesh of the destroyed component
+	* @param	bSimulatePhysics	If false, the piece has no collision and is moved by the debris subsystem
+	*/
+	void Initialize(UStaticMesh* InMesh, const TArray<UMaterialInterface*>& Materials, const float InLinearDamping, const float InAngularDamping, bool bSimulatePhysics) const;
 
-private:
-	UFUNCTION()
-	void MeshHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
+	/** Hiding the piece and stopping the physics before returning it to the pool */
+	void Deactivate() const;
 
+	/** Letting the simulated piece fall through the ground */
 	void StartSink() const;
-
-// Variables
-private:
-	uint8 bDoOnceHit : 1;
 };
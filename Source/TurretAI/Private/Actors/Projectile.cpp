@@ -2,15 +2,20 @@
 
 #include "Actors/Projectile.h"
 
-#include "Engine/AssetManager.h"
 #include "Engine/CollisionProfile.h"
-#include "Engine/StreamableManager.h"
+#include "Engine/GameInstance.h"
 #include "Engine/World.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "NiagaraComponent.h"
-#include "NiagaraFunctionLibrary.h"
 #include "Sound/SoundBase.h"
+#include "Subsystems/DamageResolverSubsystem.h"
+#include "Subsystems/ProjectilePoolSubsystem.h"
+#include "Subsystems/TurretAssetSubsystem.h"
+#include "Subsystems/TurretFXSubsystem.h"
+#include "TurretAIProfiling.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Hit"), STAT_TurretAI_ProjectileHit, STATGROUP_TurretAI);
 
 AProjectile::AProjectile()
 {
@@ -34,6 +39,7 @@ AProjectile::AProjectile()
 	
 	// Initialize variables
 	bDoOnceHit = true;
+	bActiveInPool = false;
 }
 
 void AProjectile::BeginPlay()
@@ -46,6 +52,11 @@ void AProjectile::BeginPlay()
 
 	ProjectileMesh->OnComponentHit.AddDynamic(this, &AProjectile::ProjectileHit);
 
+	InitializeMovement();
+}
+
+void AProjectile::InitializeMovement()
+{
 	if (HomingTarget.IsValid())
 	{
 		ProjectileMovement->HomingTargetComponent = HomingTarget;
@@ -54,49 +65,122 @@ void AProjectile::BeginPlay()
 	}
 }
 
-void AProjectile::LoadAssets()
+void AProjectile::ActivateFromPool()
 {
-	TArray<FSoftObjectPath> Paths;
+	const AProjectile* Defaults = GetClass()->GetDefaultObject<AProjectile>();
+	const UProjectileMovementComponent* DefaultMovement = Defaults->ProjectileMovement;
+
+	SetActorHiddenInGame(false);
+	ProjectileMesh->SetVisibility(true);
+	ProjectileMesh->SetCollisionEnabled(Defaults->ProjectileMesh->GetCollisionEnabled());
+	ProjectileMesh->SetNotifyRigidBodyCollision(true);
+	ProjectileMesh->ClearMoveIgnoreActors();
+	ProjectileMesh->IgnoreActorWhenMoving(GetOwner(), true);
 
-	if (HitParticle.ToSoftObjectPath().IsValid())
+	// Same as the initialization of the projectile movement component
+	ProjectileMovement->ProjectileGravityScale = DefaultMovement->ProjectileGravityScale;
+	ProjectileMovement->bIsHomingProjectile = DefaultMovement->bIsHomingProjectile;
+	ProjectileMovement->HomingTargetComponent = nullptr;
+	ProjectileMovement->SetUpdatedComponent(ProjectileMesh);
+
+	FVector NewVelocity = DefaultMovement->Velocity;
+	if (ProjectileMovement->InitialSpeed > 0.0f)
 	{
-		HitParticleLoaded = HitParticle.Get();
-		if (HitParticleLoaded == nullptr)
-		{
-			Paths.Add(HitParticle.ToSoftObjectPath());
-		}
+		NewVelocity = NewVelocity.GetSafeNormal() * ProjectileMovement->InitialSpeed;
 	}
 
-	if (HitSound.ToSoftObjectPath().IsValid())
+	if (ProjectileMovement->bInitialVelocityInLocalSpace)
 	{
-		HitSoundLoaded = HitSound.Get();
-		if (HitSoundLoaded == nullptr)
-		{
-			Paths.Add(HitSound.ToSoftObjectPath());
-		}
+		ProjectileMovement->SetVelocityInLocalSpace(NewVelocity);
+	}
+	else
+	{
+		ProjectileMovement->Velocity = NewVelocity;
 	}
 
-	if (Paths.IsEmpty())
+	InitializeMovement();
+
+	TrailParticle->Activate(true);
+
+	SetLifeSpan(InitialLifeSpan);
+}
+
+void AProjectile::DeactivateToPool()
+{
+	SetLifeSpan(0.0f);
+	SetOwner(nullptr);
+	SetActorHiddenInGame(true);
+
+	ProjectileMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ProjectileMesh->SetNotifyRigidBodyCollision(false);
+
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->SetUpdatedComponent(nullptr);
+
+	TrailParticle->DeactivateImmediate();
+
+	HomingTarget.Reset();
+	ProjectileAbility = 0;
+	bDoOnceHit = true;
+}
+
+void AProjectile::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bActiveInPool)
 	{
-		return;
+		if (UProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+		{
+			ProjectilePool->RemoveActiveProjectile(this);
+		}
 	}
-	
-	UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths, FStreamableDelegate::CreateWeakLambda(this, [this]
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AProjectile::LifeSpanExpired()
+{
+	if (UProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
 	{
-		if (HitParticleLoaded == nullptr)
+		if (ProjectilePool->ReleaseProjectile(this))
 		{
-			HitParticleLoaded = Cast<UNiagaraSystem>(HitParticle.Get());
+			return;
 		}
-	
-		if (HitSoundLoaded == nullptr)
+	}
+
+	Super::LifeSpanExpired();
+}
+
+void AProjectile::LoadAssets()
+{
+	TArray<FSoftObjectPath> Paths;
+
+	for (const FSoftObjectPath& Path : { HitParticle.ToSoftObjectPath(), HitSound.ToSoftObjectPath() })
+	{
+		if (Path.IsValid())
 		{
-			HitSoundLoaded = Cast<USoundBase>(HitSound.Get());
+			Paths.Add(Path);
 		}
-	}));
+	}
+
+	// All projectiles of the same class share the same assets, so only the first projectile needs to wait for them
+	const UGameInstance* GameInstance = GetGameInstance();
+	UTurretAssetSubsystem* AssetSubsystem = GameInstance ? GameInstance->GetSubsystem<UTurretAssetSubsystem>() : nullptr;
+	if (AssetSubsystem == nullptr || AssetSubsystem->RequestClassAssets(GetClass(), Paths, FStreamableDelegate::CreateUObject(this, &AProjectile::ResolveAssets)))
+	{
+		ResolveAssets();
+	}
+}
+
+void AProjectile::ResolveAssets()
+{
+	HitParticleLoaded = HitParticle.Get();
+	HitSoundLoaded = HitSound.Get();
 }
 
 void AProjectile::ProjectileHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_ProjectileHit);
+
 	if (bDoOnceHit == false)
 	{
 		return;
@@ -115,35 +199,44 @@ void AProjectile::ProjectileHit(UPrimitiveComponent* HitComponent, AActor* Other
 	
 	if (HasFlag(EProjectileAbility::Explosive))
 	{
-		ApplyExplosiveHit(Hit);
+		ApplyExplosiveHit(this, DamageInfo, Hit, GetInstigatorController(), GetOwner());
 	}
 	else
 	{
-		ApplyNormalHit(Hit);
+		ApplyNormalHit(DamageInfo, Hit, GetInstigatorController(), GetOwner());
 	}
 }
 
-void AProjectile::ApplyNormalHit(const FHitResult& HitResult) const
+void AProjectile::ApplyNormalHit(const FRadialDamageParams& InDamageInfo, const FHitResult& HitResult, AController* InstigatorController, AActor* DamageCauser)
 {
-	UGameplayStatics::ApplyPointDamage(HitResult.GetActor(), DamageInfo.BaseDamage, HitResult.ImpactNormal, HitResult,
-		GetInstigatorController(), GetOwner(), nullptr);
+	TURRETAI_PROFILE_SCOPE(Damage);
+
+	UGameplayStatics::ApplyPointDamage(HitResult.GetActor(), InDamageInfo.BaseDamage, HitResult.ImpactNormal, HitResult,
+		InstigatorController, DamageCauser, nullptr);
 }
 
-void AProjectile::ApplyExplosiveHit(const FHitResult& HitResult) const
+void AProjectile::ApplyExplosiveHit(const UObject* WorldContextObject, const FRadialDamageParams& InDamageInfo, const FHitResult& HitResult, AController* InstigatorController, AActor* DamageCauser)
 {
-	UGameplayStatics::ApplyRadialDamageWithFalloff(GetWorld(), DamageInfo.BaseDamage, DamageInfo.MinimumDamage, HitResult.ImpactPoint,
-		DamageInfo.InnerRadius, DamageInfo.OuterRadius, 1.0f, nullptr, TArray<AActor*>(), GetOwner(), GetInstigatorController());
+	TURRETAI_PROFILE_SCOPE(Damage);
+
+	// Explosions of the same frame are resolved together at the end of the frame
+	UWorld* World = WorldContextObject->GetWorld();
+	if (UDamageResolverSubsystem* DamageResolver = World ? World->GetSubsystem<UDamageResolverSubsystem>() : nullptr)
+	{
+		DamageResolver->AddExplosion(InDamageInfo, HitResult.ImpactPoint, InstigatorController, DamageCauser);
+		return;
+	}
+
+	UGameplayStatics::ApplyRadialDamageWithFalloff(WorldContextObject, InDamageInfo.BaseDamage, InDamageInfo.MinimumDamage, HitResult.ImpactPoint,
+		InDamageInfo.InnerRadius, InDamageInfo.OuterRadius, 1.0f, nullptr, TArray<AActor*>(), DamageCauser, InstigatorController);
 }
 
 void AProjectile::DisableProjectile()
 {
-	FFXSystemSpawnParameters SpawnParams;
-	SpawnParams.WorldContextObject = GetWorld();
-	SpawnParams.SystemTemplate = HitParticleLoaded;
-	SpawnParams.Location = ProjectileMesh->GetComponentLocation();
-	UNiagaraFunctionLibrary::SpawnSystemAtLocationWithParams(SpawnParams);
-	
-	UGameplayStatics::SpawnSoundAtLocation(SpawnParams.WorldContextObject, HitSoundLoaded, GetActorLocation());
+	if (UTurretFXSubsystem* FXSubsystem = GetWorld()->GetSubsystem<UTurretFXSubsystem>())
+	{
+		FXSubsystem->RequestFX(HitParticleLoaded, HitSoundLoaded, ProjectileMesh->GetComponentLocation());
+	}
 
 	ProjectileMesh->SetSimulatePhysics(false);
 	ProjectileMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
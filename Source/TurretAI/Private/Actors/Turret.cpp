@@ -5,22 +5,63 @@
 #include "Actors/Projectile.h"
 #include "Components/HealthComponent.h"
 #include "Components/SphereComponent.h"
-#include "DestroyedStructure.h"
 #include "Engine/AssetManager.h"
 #include "Engine/CollisionProfile.h"
-#include "Engine/StreamableManager.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StaticMesh.h"
 #include "Engine/World.h"
-#include "Kismet/GameplayStatics.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/ProjectileMovementComponent.h"
 #include "Net/UnrealNetwork.h"
-#include "NiagaraFunctionLibrary.h"
-#include "TimerManager.h"
+#include "NiagaraSystem.h"
+#include "Sound/SoundBase.h"
+#include "Subsystems/ProjectilePoolSubsystem.h"
+#include "Subsystems/ProjectileSimulationSubsystem.h"
+#include "Subsystems/TurretAssetSubsystem.h"
+#include "Subsystems/TurretDebrisSubsystem.h"
+#include "Subsystems/TurretFireEventSubsystem.h"
+#include "Subsystems/TurretFXSubsystem.h"
+#include "Subsystems/TurretManagerSubsystem.h"
+#include "Subsystems/TurretTargetSubsystem.h"
+#include "TurretAI.h"
+#include "TurretAIProfiling.h"
+#include "Types/TurretAimSolver.h"
+#include "Types/TurretRandom.h"
+
+DECLARE_CYCLE_STAT(TEXT("Find New Target"), STAT_TurretAI_FindNewTarget, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Spawn Projectile"), STAT_TurretAI_SpawnProjectile, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Spawn Fire FX"), STAT_TurretAI_SpawnFireFX, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Can See Target"), STAT_TurretAI_CanSeeTarget, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Can Hit Target"), STAT_TurretAI_CanHitTarget, STATGROUP_TurretAI);
+
+/** User data flags of the can hit target sweep */
+static constexpr uint32 CanHitDropTargetFlag = 1 << 0;
+static constexpr uint32 CanHitPredictedFlag = 1 << 1;
+
+/** Results of the segment sweeps of the can hit check */
+static constexpr uint8 CanHitSegmentClear = 0;
+static constexpr uint8 CanHitSegmentTarget = 1;
+static constexpr uint8 CanHitSegmentBlocked = 2;
+
+/** Seconds that a demoted turret is kept on the server, long enough for the tear off to reach the clients */
+static constexpr float DemotedLifeSpan = 2.0f;
+
+static float GetServerWorldTime(const UWorld* World)
+{
+	const AGameStateBase* GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
 
 ATurret::ATurret()
 {
-	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.bStartWithTickEnabled = false;
+	// Rotation is updated in batch by the turret manager subsystem
+	PrimaryActorTick.bCanEverTick = false;
 	bReplicates = true;
 	NetUpdateFrequency = 5.0f;
+	NetDormancy = DORM_DormantAll;
+	bDemotedToProxy = false;
+	bCosmeticRotatingParts = false;
 	
 	BaseMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Base Mesh"));
 	RootComponent = BaseMesh;
@@ -45,17 +86,15 @@ ATurret::ATurret()
 	Detector->bUseAttachParentBound = true;
 
 	HealthComp = CreateDefaultSubobject<UHealthComponent>(TEXT("Health Component"));
-
-	// Initialize variables
-	bCanRotateRandomly = true;
 }
 
 void ATurret::GetLifetimeReplicatedProps(TArray<FLifetimeProperty> &OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ATurret, CurrentTarget);
-	DOREPLIFETIME(ATurret, RandomRotation);
+	DOREPLIFETIME(ATurret, AimState);
+	DOREPLIFETIME_CONDITION(ATurret, RandomSeed, COND_InitialOnly);
+	DOREPLIFETIME(ATurret, bDemotedToProxy);
 }
 
 void ATurret::BeginPlay()
@@ -64,121 +103,214 @@ void ATurret::BeginPlay()
 
 	LoadAssets();
 
+	Scheduler = GetWorld()->GetSubsystem<UTurretSchedulerSubsystem>();
+
+	if (HasAuthority())
+	{
+		RandomSeed = FTurretRandom::MakeTurretSeed(GetWorld(), GetFName());
+		FireRandomStream.Initialize(RandomSeed);
+	}
+
+	SweepRandomStream = FTurretRandom::MakeSweepStream(RandomSeed, AimState.SweepPeriod);
+
+	// Clients that have received a target before BeginPlay hold the aim of the server
+	if (AimState.bHasTarget == false)
+	{
+		StartIdleSweep(0.0f);
+	}
+
+	if (bCosmeticRotatingParts)
+	{
+		GetYawComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		GetPitchComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	}
+
+	if (UTurretManagerSubsystem* TurretManager = GetWorld()->GetSubsystem<UTurretManagerSubsystem>())
+	{
+		TurretManager->RegisterTurret(this);
+	}
+
 	if (HasAuthority())
 	{
-		FindRandomRotation();
+		CanSeeTargetDelegate.BindUObject(this, &ATurret::OnCanSeeTargetTraceDone);
+		CanHitTargetDelegate.BindUObject(this, &ATurret::OnCanHitTargetTraceDone);
 		
 		HealthComp->Activate(false);
-		
-		Detector->SetGenerateOverlapEvents(true);
-		Detector->OnComponentBeginOverlap.AddDynamic(this, &ATurret::DetectorBeginOverlap);
-		Detector->OnComponentEndOverlap.AddDynamic(this, &ATurret::DetectorEndOverlap);
+		HealthComp->OnHealthChanged.AddUObject(this, &ATurret::OnHealthChanged);
+
+		if (DetectionMode == ETurretDetectionMode::SpatialIndex)
+		{
+			if (UTurretTargetSubsystem* TargetSubsystem = GetWorld()->GetSubsystem<UTurretTargetSubsystem>())
+			{
+				TargetSubsystem->RegisterTurret(this);
+			}
+		}
+		else
+		{
+			Detector->SetGenerateOverlapEvents(true);
+			Detector->OnComponentBeginOverlap.AddDynamic(this, &ATurret::DetectorBeginOverlap);
+			Detector->OnComponentEndOverlap.AddDynamic(this, &ATurret::DetectorEndOverlap);
+
+			// Actors that were inside the detector before the overlap events were bound
+			TArray<AActor*> OverlappingActors;
+			Detector->GetOverlappingActors(OverlappingActors);
+			DetectedActors.Append(OverlappingActors);
+		}
+	}
+
+	// The detector is only used for its radius when the spatial index is used
+	if (DetectionMode == ETurretDetectionMode::SpatialIndex)
+	{
+		Detector->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	}
 }
 
-void ATurret::Tick(float DeltaTime)
+void ATurret::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
-
-	// Turret will start rotation randomly if there is no target.
-	if (HasAuthority() && bCanRotateRandomly && CurrentTarget == nullptr)
+	if (UTurretManagerSubsystem* TurretManager = GetWorld()->GetSubsystem<UTurretManagerSubsystem>())
 	{
-		bCanRotateRandomly = false;
+		TurretManager->UnregisterTurret(this);
+	}
 
-		// Delay between switching to a new rotation
-		FTimerHandle TimerHandle;
-		GetWorld()->GetTimerManager().SetTimer(TimerHandle, this, &ATurret::FindRandomRotation, 2.0f);
+	if (UTurretTargetSubsystem* TargetSubsystem = GetWorld()->GetSubsystem<UTurretTargetSubsystem>())
+	{
+		TargetSubsystem->UnregisterTurret(this);
 	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void ATurret::LoadAssets()
 {
-	TArray<FSoftObjectPath> Paths;
+	if (Archetype.IsNull())
+	{
+		LoadClassAssets();
+		return;
+	}
 
-	if (Projectile.ToSoftObjectPath().IsValid())
+	// The archetype is loaded with the bundle of its projectile and effects, and is shared by all turrets that use it
+	UAssetManager& AssetManager = UAssetManager::Get();
+	const FPrimaryAssetId ArchetypeId = AssetManager.GetPrimaryAssetIdForPath(Archetype.ToSoftObjectPath());
+	if (ArchetypeId.IsValid() == false)
 	{
-		ProjectileLoaded = Projectile.Get();
-		if (ProjectileLoaded == nullptr)
-		{
-			Paths.Add(Projectile.ToSoftObjectPath());
-		}
+		UE_LOG(LogTurretAI, Warning, TEXT("%s: %s is not registered with the asset manager, the class defaults are used"),
+			*GetName(), *Archetype.ToString());
+		LoadClassAssets();
+		return;
 	}
 
-	if (FireParticle.ToSoftObjectPath().IsValid())
+	const TSharedPtr<FStreamableHandle> Handle = AssetManager.LoadPrimaryAsset(ArchetypeId, { UTurretArchetype::GameBundle },
+		FStreamableDelegate::CreateUObject(this, &ATurret::OnArchetypeLoaded));
+	if (Handle.IsValid() == false || Handle->HasLoadCompleted())
 	{
-		FireParticleLoaded = FireParticle.Get();
-		if (FireParticleLoaded == nullptr)
-		{
-			Paths.Add(FireParticle.ToSoftObjectPath());
-		}
+		OnArchetypeLoaded();
 	}
+}
 
-	if (FireSound.ToSoftObjectPath().IsValid())
+void ATurret::OnArchetypeLoaded()
+{
+	// Already handled when the archetype was loaded before the request
+	if (ArchetypeLoaded)
 	{
-		FireSoundLoaded = FireSound.Get();
-		if (FireSoundLoaded == nullptr)
-		{
-			Paths.Add(FireSound.ToSoftObjectPath());
-		}
+		return;
 	}
 
-	if (DestroyParticle.ToSoftObjectPath().IsValid())
+	ArchetypeLoaded = Archetype.Get();
+	if (ArchetypeLoaded == nullptr)
 	{
-		DestroyParticleLoaded = DestroyParticle.Get();
-		if (DestroyParticleLoaded == nullptr)
+		LoadClassAssets();
+		return;
+	}
+
+	// Turrets that registered before the archetype was loaded use the info of the class
+	if (UTurretManagerSubsystem* TurretManager = GetWorld()->GetSubsystem<UTurretManagerSubsystem>())
+	{
+		TurretManager->RefreshTurretInfo(this);
+	}
+
+	ResolveAssets();
+}
+
+void ATurret::LoadClassAssets()
+{
+	TArray<FSoftObjectPath> Paths;
+	GetClassAssetPaths(Paths);
+
+	// All turrets of the same class share the same assets, so only the first turret needs to wait for them
+	const UGameInstance* GameInstance = GetGameInstance();
+	UTurretAssetSubsystem* AssetSubsystem = GameInstance ? GameInstance->GetSubsystem<UTurretAssetSubsystem>() : nullptr;
+	if (AssetSubsystem == nullptr || AssetSubsystem->RequestClassAssets(GetClass(), Paths, FStreamableDelegate::CreateUObject(this, &ATurret::ResolveAssets)))
+	{
+		ResolveAssets();
+	}
+}
+
+void ATurret::GetClassAssetPaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+	for (const FSoftObjectPath& Path : { Projectile.ToSoftObjectPath(), FireParticle.ToSoftObjectPath(), FireSound.ToSoftObjectPath(),
+		DestroyParticle.ToSoftObjectPath(), DestroySound.ToSoftObjectPath() })
+	{
+		if (Path.IsValid())
 		{
-			Paths.Add(DestroyParticle.ToSoftObjectPath());
+			OutPaths.Add(Path);
 		}
 	}
+}
 
-	if (DestroySound.ToSoftObjectPath().IsValid())
+void ATurret::ResolveAssets()
+{
+	if (ArchetypeLoaded)
+	{
+		ProjectileLoaded = ArchetypeLoaded->Projectile.Get();
+		FireParticleLoaded = ArchetypeLoaded->FireParticle.Get();
+		FireSoundLoaded = ArchetypeLoaded->FireSound.Get();
+		DestroyParticleLoaded = ArchetypeLoaded->DestroyParticle.Get();
+		DestroySoundLoaded = ArchetypeLoaded->DestroySound.Get();
+	}
+	else
 	{
+		ProjectileLoaded = Projectile.Get();
+		FireParticleLoaded = FireParticle.Get();
+		FireSoundLoaded = FireSound.Get();
+		DestroyParticleLoaded = DestroyParticle.Get();
 		DestroySoundLoaded = DestroySound.Get();
-		if (DestroySoundLoaded == nullptr)
+	}
+
+	// Used by the aim solver to lead the target
+	if (ProjectileLoaded)
+	{
+		const UProjectileMovementComponent* ProjectileMovement = GetDefault<AProjectile>(ProjectileLoaded)->GetProjectileMovement();
+		ProjectileSpeed = ProjectileMovement->InitialSpeed > 0.0f ? ProjectileMovement->InitialSpeed : ProjectileMovement->Velocity.Size();
+		ProjectileGravityZ = GetWorld()->GetGravityZ() * ProjectileMovement->ProjectileGravityScale;
+
+		// Same radius as the simulated projectiles
+		const UStaticMeshComponent* ProjectileMesh = GetDefault<AProjectile>(ProjectileLoaded)->GetProjectileMesh();
+		if (ProjectileMesh->GetStaticMesh())
 		{
-			Paths.Add(DestroySound.ToSoftObjectPath());
+			ProjectileRadius = ProjectileMesh->GetStaticMesh()->GetBounds().SphereRadius * ProjectileMesh->GetRelativeScale3D().GetMax();
 		}
 	}
 
-	if (Paths.IsEmpty())
+	PrewarmProjectiles();
+}
+
+void ATurret::PrewarmProjectiles() const
+{
+	if (ProjectileBackend != EProjectileBackend::Actor)
 	{
-		SetActorTickEnabled(true);
 		return;
 	}
-	
-	UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths, FStreamableDelegate::CreateWeakLambda(this, [this]
-	{
-		if (ProjectileLoaded == nullptr)
-		{
-			ProjectileLoaded = Projectile.Get();
-		}
-	
-		if (FireParticleLoaded == nullptr)
-		{
-			FireParticleLoaded = FireParticle.Get();
-		}
-	
-		if (FireSoundLoaded == nullptr)
-		{
-			FireSoundLoaded = FireSound.Get();
-		}
-	
-		if (DestroyParticleLoaded == nullptr)
-		{
-			DestroyParticleLoaded = DestroyParticle.Get();
-		}
-	
-		if (DestroySoundLoaded == nullptr)
-		{
-			DestroySoundLoaded = DestroySound.Get();
-		}
 
-		SetActorTickEnabled(true);
-	}));
+	if (UProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+	{
+		ProjectilePool->Prewarm(ProjectileLoaded);
+	}
 }
 
 void ATurret::DetectorBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+	DetectedActors.AddUnique(OtherActor);
+
 	if (CurrentTarget == nullptr)
 	{
 		FindNewTarget();
@@ -187,6 +319,12 @@ void ATurret::DetectorBeginOverlap(UPrimitiveComponent* OverlappedComponent, AAc
 
 void ATurret::DetectorEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
 {
+	// The actor may still overlap the detector with its other components
+	if (Detector->IsOverlappingActor(OtherActor) == false)
+	{
+		DetectedActors.Remove(OtherActor);
+	}
+
 	if (OtherActor == CurrentTarget)
 	{
 		FindNewTarget();
@@ -195,76 +333,186 @@ void ATurret::DetectorEndOverlap(UPrimitiveComponent* OverlappedComponent, AActo
 
 void ATurret::FindNewTarget()
 {
-	// Clear the search timer because we are starting a new search
-	GetWorld()->GetTimerManager().ClearTimer(SearchTimer);
+	// Clear the pending traces because we are starting a new search
+	CanSeeTraceHandles.Reset();
+	CanHitTraceHandles.Reset();
 	
-	CurrentTarget = nullptr;
+	SetCurrentTarget(nullptr);
+	SetState(ETurretState::Acquiring);
 	
-	FindNewTargetImpl();
+	// The search runs as soon as the per frame budget of the scheduler allows it
+	ScheduleTask(ETurretTask::Search, 0.0f);
 
-	// Only reset the random rotation if the turret is not switching between targets.
-	if (CurrentTarget == nullptr)
+	// Start random rotation if failed to find another target.
+	ScheduleTask(ETurretTask::RandomRotation, 2.0f);
+}
+
+void ATurret::FindNewTargetImpl()
+{
+	if (GatherTargetCandidates())
 	{
-		// Start random rotation if failed to find another target.
-		bCanRotateRandomly = true;
+		RankTargets();
+		RequestCanSeeTargets(TargetCandidates);
 	}
 }
 
-void ATurret::FindNewTargetImpl()
+bool ATurret::GatherTargetCandidates()
 {
-	TArray<AActor*> Actors;
-	Detector->GetOverlappingActors(Actors);
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_FindNewTarget);
+	TURRETAI_PROFILE_SCOPE(Targeting);
+
+	TargetCandidates.Reset();
+	GetTargetsInRange(TargetCandidates);
 
-	if (Actors.IsEmpty())
+	if (TargetCandidates.IsEmpty())
 	{
-		return;
+		EnterDormancy();
+		StartIdleSweep(2.0f);
+		return false;
 	}
-	
-	for (AActor* NewTarget : Actors)
+
+	SearchOrigin = Detector->GetComponentLocation();
+	SearchForward = BarrelMesh->GetForwardVector();
+	SearchRadius = Detector->GetScaledSphereRadius();
+
+	TargetSnapshots.Reset(TargetCandidates.Num());
+	for (AActor* Target : TargetCandidates)
 	{
-		if (CanSeeTarget(NewTarget))
+		if (Target == this)
 		{
-			CurrentTarget = NewTarget;
-			StartFireTurret();
-			return;
+			continue;
+		}
+
+		FTargetSnapshot& Snapshot = TargetSnapshots.AddDefaulted_GetRef();
+		Snapshot.Target = Target;
+		Snapshot.Location = Target->GetActorLocation();
+
+		if (const UHealthComponent* TargetHealth = Target->FindComponentByClass<UHealthComponent>())
+		{
+			Snapshot.HealthRatio = FMath::Clamp(TargetHealth->GetHealth() / FMath::Max(TargetHealth->GetMaxHealth(), 1.0f), 0.0f, 1.0f);
+		}
+
+		if (const APawn* TargetPawn = Cast<APawn>(Target))
+		{
+			Snapshot.bPlayerControlled = TargetPawn->IsPlayerControlled();
 		}
 	}
 
-	// Retry
-	GetWorld()->GetTimerManager().SetTimer(SearchTimer, this, &ATurret::FindNewTargetImpl, 0.5f);
+	return true;
 }
 
-void ATurret::StartFireTurret()
+void ATurret::GetTargetsInRange(TArray<AActor*>& OutTargets)
 {
-	if (CanHitTarget(CurrentTarget))
+	if (DetectionMode == ETurretDetectionMode::SpatialIndex)
 	{
-		HandleFireTurret();
+		if (const UTurretTargetSubsystem* TargetSubsystem = GetWorld()->GetSubsystem<UTurretTargetSubsystem>())
+		{
+			TargetSubsystem->QueryTargets(Detector->GetComponentLocation(), Detector->GetScaledSphereRadius(), OutTargets);
+		}
+
+		return;
+	}
+
+	for (int32 i = DetectedActors.Num() - 1; i >= 0; --i)
+	{
+		if (AActor* DetectedActor = DetectedActors[i].Get())
+		{
+			OutTargets.Add(DetectedActor);
+		}
+		else
+		{
+			DetectedActors.RemoveAtSwap(i, 1, false);
+		}
+	}
+}
+
+void ATurret::RankTargets()
+{
+	TURRETAI_PROFILE_SCOPE(Targeting);
+
+	ScoredTargets.Reset(TargetSnapshots.Num());
+	for (const FTargetSnapshot& Snapshot : TargetSnapshots)
+	{
+		ScoredTargets.Emplace(ScoreTarget(Snapshot), Snapshot.Target);
+	}
+
+	ScoredTargets.Sort([](const TPair<float, AActor*>& A, const TPair<float, AActor*>& B)
+	{
+		return A.Key > B.Key;
+	});
+
+	const int32 NumChecks = FMath::Min(ScoredTargets.Num(), TargetScoring.MaxVisibilityChecks);
+
+	TargetCandidates.Reset();
+	for (int32 i = 0; i < NumChecks; ++i)
+	{
+		TargetCandidates.Add(ScoredTargets[i].Value);
 	}
+
+	// The rest are only checked if the best ones are behind cover, and they may be destroyed before that
+	VisibilityFallbacks.Reset(ScoredTargets.Num() - NumChecks);
+	for (int32 i = NumChecks; i < ScoredTargets.Num(); ++i)
+	{
+		VisibilityFallbacks.Add(ScoredTargets[i].Value);
+	}
+	NextVisibilityFallback = 0;
+}
+
+float ATurret::ScoreTarget(const FTargetSnapshot& Snapshot) const
+{
+	const FVector Offset = Snapshot.Location - SearchOrigin;
+	const float Distance = Offset.Size();
+
+	float Score = TargetScoring.DistanceWeight * (1.0f - FMath::Clamp(Distance / FMath::Max(SearchRadius, 1.0f), 0.0f, 1.0f));
+
+	// Map the angle to the barrel from [-1, 1] to [0, 1]
+	Score += TargetScoring.AngleWeight * (FVector::DotProduct(SearchForward, Offset / FMath::Max(Distance, 1.0f)) + 1.0f) * 0.5f;
+
+	// Targets without a health component have a full health ratio
+	Score += TargetScoring.HealthWeight * (1.0f - Snapshot.HealthRatio);
+
+	Score += Snapshot.bPlayerControlled ? TargetScoring.ThreatWeight : 0.0f;
+
+	return Score;
+}
+
+void ATurret::StartFireTurret()
+{
+	// The turret may not be aimed at the new target yet, so only drop it if the next checks fail
+	RequestCanHitTarget(false);
 	
-	GetWorld()->GetTimerManager().SetTimer(FireTimer, this, &ATurret::FireTurret, TurretInfo.FireRate, true);
+	ScheduleTask(ETurretTask::Fire, GetTurretInfo().FireRate);
 }
 
 void ATurret::FireTurret()
 {
-	if (CurrentTarget && CanHitTarget(CurrentTarget))
+	if (CurrentTarget)
 	{
-		HandleFireTurret();
+		// Schedule the next shot before the check, a failed check cancels it
+		ScheduleTask(ETurretTask::Fire, GetTurretInfo().FireRate);
+		RequestCanHitTarget(true);
 	}
 	else
 	{
-		GetWorld()->GetTimerManager().ClearTimer(FireTimer);
 		FindNewTarget();
 	}
 }
 
 void ATurret::HandleFireTurret()
 {
-	MulticastFireTurret();
+	const uint16 Seed = static_cast<uint16>(FireRandomStream.GetUnsignedInt());
+
+	PlayFireEvent(Seed);
+
+	if (UTurretFireEventSubsystem* FireEvents = GetWorld()->GetSubsystem<UTurretFireEventSubsystem>())
+	{
+		FireEvents->AddFireEvent(this, Seed);
+	}
 }
 
-void ATurret::MulticastFireTurret_Implementation()
+void ATurret::PlayFireEvent(uint16 Seed)
 {
-	if (CurrentTarget == nullptr)
+	if (CanPlayFireEvent() == false)
 	{
 		return;
 	}
@@ -275,20 +523,40 @@ void ATurret::MulticastFireTurret_Implementation()
 
 void ATurret::SpawnProjectile(const FTransform& Transform)
 {
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_SpawnProjectile);
+	TURRETAI_PROFILE_SCOPE(Spawn);
+
 	if (ProjectileLoaded == nullptr)
 	{
 		return;
 	}
+
+	if (ProjectileBackend == EProjectileBackend::Simulated)
+	{
+		if (UProjectileSimulationSubsystem* ProjectileSimulation = GetWorld()->GetSubsystem<UProjectileSimulationSubsystem>())
+		{
+			USceneComponent* HomingTarget = GetTurretInfo().HasFlag(ETurretAbility::Homing) ? CurrentTarget->GetRootComponent() : nullptr;
+			ProjectileSimulation->FireProjectile(ProjectileLoaded, Transform, this, GetInstigator(), HomingTarget, GetTurretInfo().HasFlag(ETurretAbility::ExplosiveShot));
+		}
+
+		return;
+	}
+
+	UProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>();
+	if (ProjectilePool == nullptr)
+	{
+		return;
+	}
 	
-	if (AProjectile* NewProjectile = GetWorld()->SpawnActorDeferred<AProjectile>(ProjectileLoaded, Transform, this, GetInstigator()))
+	if (AProjectile* NewProjectile = ProjectilePool->AcquireProjectile(ProjectileLoaded, Transform, this, GetInstigator()))
 	{
 		// Initialize the projectile
-		if (TurretInfo.HasFlag(ETurretAbility::Homing))
+		if (GetTurretInfo().HasFlag(ETurretAbility::Homing))
 		{
 			NewProjectile->HomingTarget = CurrentTarget->GetRootComponent();
 		}
 		
-		if (TurretInfo.HasFlag(ETurretAbility::ExplosiveShot))
+		if (GetTurretInfo().HasFlag(ETurretAbility::ExplosiveShot))
 		{
 			NewProjectile->SetFlag(EProjectileAbility::Explosive);
 		}
@@ -296,124 +564,564 @@ void ATurret::SpawnProjectile(const FTransform& Transform)
 		// Ignoring collisions between barrel and projectile
 		BarrelMesh->IgnoreActorWhenMoving(NewProjectile, true);
 		
-		UGameplayStatics::FinishSpawningActor(NewProjectile, Transform);
+		UProjectilePoolSubsystem::LaunchProjectile(NewProjectile, Transform);
 	}
 }
 
 void ATurret::SpawnFireFX() const
 {
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_SpawnFireFX);
+	TURRETAI_PROFILE_SCOPE(Spawn);
+
+	// Dedicated servers don't have the FX subsystem
+	UTurretFXSubsystem* FXSubsystem = GetWorld()->GetSubsystem<UTurretFXSubsystem>();
+	if (FXSubsystem == nullptr)
+	{
+		return;
+	}
+
 	const FTransform NewTransform = BarrelMesh->GetSocketTransform("MuzzleSocket");
-	
-	FFXSystemSpawnParameters SpawnParams;
-	SpawnParams.WorldContextObject = GetWorld();;
-	SpawnParams.SystemTemplate = FireParticleLoaded;
-	SpawnParams.Location = NewTransform.GetLocation();
-	SpawnParams.Rotation = NewTransform.GetRotation().Rotator();
-	SpawnParams.Scale = GetActorScale3D() + 0.5f;
-	UNiagaraFunctionLibrary::SpawnSystemAtLocationWithParams(SpawnParams);
-	
-	UGameplayStatics::SpawnSoundAtLocation(SpawnParams.WorldContextObject, FireSoundLoaded, SpawnParams.Location, SpawnParams.Rotation);
+	FXSubsystem->RequestFX(FireParticleLoaded, FireSoundLoaded, NewTransform.GetLocation(), NewTransform.GetRotation().Rotator(), GetActorScale3D() + 0.5f);
 }
 
 void ATurret::FindRandomRotation()
 {
-	if (CurrentTarget)
+	// The turret sleeps until a detection or a wake signal
+	if (State == ETurretState::IdleSweep && GetWorld()->GetTimeSeconds() >= IdleSweepEndTime)
+	{
+		Sleep();
+		return;
+	}
+
+	// Idle sweeps are cosmetic, and clients have their own
+	if (CurrentTarget || AimState.bHasTarget || GetNetMode() == NM_DedicatedServer)
 	{
 		return;
 	}
 	
-	if (FMath::IsNearlyEqual(RandomRotation.Pitch, BarrelMesh->GetRelativeRotation().Pitch, 1))
+	if (FMath::Abs(FRotator::NormalizeAxis(RandomRotation.Pitch - BarrelMesh->GetRelativeRotation().Pitch)) <= 1.0f)
 	{
-		RandomRotation = FRotator(FMath::RandRange(TurretInfo.MinPitch, TurretInfo.MaxPitch), FMath::RandRange(-180.0f, 180.0f), 0.0f);
-			
-		bCanRotateRandomly = true;
+		RandomRotation = FTurretRandom::MakeSweepRotation(SweepRandomStream, GetTurretInfo().MinPitch, GetTurretInfo().MaxPitch);
+
+		// Delay between switching to a new rotation
+		ScheduleTask(ETurretTask::RandomRotation, 2.0f);
 	}
 	else
 	{
 		// When the barrel hasn't reached the target rotation, retry after a delay
-		FTimerHandle TimerHandle;
-		GetWorld()->GetTimerManager().SetTimer(TimerHandle, this, &ATurret::FindRandomRotation, 1.0f);
+		ScheduleTask(ETurretTask::RandomRotation, 1.0f);
 	}
 }
 
-FRotator ATurret::CalculateRotation(const UStaticMeshComponent* CompToRotate, float DeltaTime) const
+void ATurret::SetCurrentTarget(AActor* NewTarget)
 {
-	if (CurrentTarget)
+	CurrentTarget = NewTarget;
+
+	if (NewTarget)
 	{
-		// Follow the target
-		const FVector NewLocation = CurrentTarget->GetActorLocation() - BarrelMesh->GetComponentLocation();
-		const FRotator TargetRotation = FRotationMatrix::MakeFromX(GetActorTransform().InverseTransformVectorNoScale(NewLocation)).Rotator();	// Inverse Transform Direction
+		SetState(ETurretState::Engaging);
+	}
 
-		return FMath::RInterpConstantTo(CompToRotate->GetRelativeRotation(), TargetRotation, DeltaTime, TurretInfo.RotationSpeed);
+	if (AimState.Target == NewTarget && AimState.bHasTarget == (NewTarget != nullptr))
+	{
+		return;
+	}
+
+	// Wake up before changing the state, dormant actors don't replicate their changes
+	if (NewTarget)
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+
+	// Every machine starts the same idle sweep
+	if (NewTarget == nullptr)
+	{
+		++AimState.SweepPeriod;
+		SweepRandomStream = FTurretRandom::MakeSweepStream(RandomSeed, AimState.SweepPeriod);
+	}
+
+	AimState.bHasTarget = NewTarget != nullptr;
+	AimState.Target = NewTarget;
+	AimState.SetRotation(GetYawComponent()->GetRelativeRotation().Yaw, GetPitchComponent()->GetRelativeRotation().Pitch);
+	AimState.ServerTime = GetServerWorldTime(GetWorld());
+}
+
+void ATurret::EnterDormancy()
+{
+	// The last aim state is still sent before the actor becomes dormant
+	if (CurrentTarget == nullptr && NetDormancy != DORM_DormantAll)
+	{
+		SetNetDormancy(DORM_DormantAll);
 	}
-	
-	// Perform random rotation
-	return FMath::RInterpConstantTo(CompToRotate->GetRelativeRotation(), RandomRotation, DeltaTime, TurretInfo.RotationSpeed);
 }
 
-bool ATurret::CanSeeTarget(AActor* Target) const
+void ATurret::ScheduleTask(ETurretTask Task, float Delay)
 {
+	if (Scheduler)
+	{
+		Scheduler->Schedule(this, Task, Delay);
+	}
+}
+
+void ATurret::CancelTask(ETurretTask Task)
+{
+	if (Scheduler)
+	{
+		Scheduler->Cancel(this, Task);
+	}
+}
+
+void ATurret::SetState(ETurretState NewState)
+{
+	// Destroyed turrets can't be woken up by the pending events
+	if (State == NewState || State == ETurretState::Destroyed)
+	{
+		return;
+	}
+
+	if (UTurretManagerSubsystem* TurretManager = GetWorld()->GetSubsystem<UTurretManagerSubsystem>())
+	{
+		TurretManager->SetTurretState(this, NewState);
+	}
+
+	State = NewState;
+}
+
+void ATurret::StartIdleSweep(float Delay)
+{
+	// Dedicated servers don't sweep, so there is nothing to wait for
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		Sleep();
+		return;
+	}
+
+	SetState(ETurretState::IdleSweep);
+	IdleSweepEndTime = GetWorld()->GetTimeSeconds() + Delay + IdleSweepDuration;
+
+	ScheduleTask(ETurretTask::RandomRotation, Delay);
+}
+
+void ATurret::Sleep()
+{
+	SetState(ETurretState::Dormant);
+
+	CancelTask(ETurretTask::Search);
+	CancelTask(ETurretTask::Fire);
+	CancelTask(ETurretTask::RandomRotation);
+
+	EnterDormancy();
+}
+
+void ATurret::DemoteToProxy()
+{
+	bDemotedToProxy = true;
+
+	if (GetNetMode() == NM_Standalone)
+	{
+		Destroy();
+		return;
+	}
+
+	// Destroying right away would close the channels before the flag is sent, so the turret is torn off and kept hidden for a moment
+	CancelTask(ETurretTask::Search);
+	CancelTask(ETurretTask::Fire);
+	CancelTask(ETurretTask::RandomRotation);
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetCanBeDamaged(false);
+
+	// Dormant turrets would never send the tear off
+	SetNetDormancy(DORM_Awake);
+	TearOff();
+	SetLifeSpan(DemotedLifeSpan);
+}
+
+void ATurret::Wake()
+{
+	if (State != ETurretState::Dormant)
+	{
+		return;
+	}
+
+	if (HasAuthority())
+	{
+		FindNewTarget();
+	}
+	else
+	{
+		StartIdleSweep(0.0f);
+	}
+}
+
+void ATurret::OnRep_RandomSeed()
+{
+	SweepRandomStream = FTurretRandom::MakeSweepStream(RandomSeed, AimState.SweepPeriod);
+}
+
+void ATurret::OnRep_AimState()
+{
+	CurrentTarget = AimState.Target;
+
+	// Without a relevant target the turret holds the last aim of the server, and idle turrets start their sweep from there
+	RandomRotation = AimState.GetRotation();
+
+	if (AimState.bHasTarget == false)
+	{
+		SweepRandomStream = FTurretRandom::MakeSweepStream(RandomSeed, AimState.SweepPeriod);
+
+		// The initial state arrives before BeginPlay, which starts the sweep itself
+		if (Scheduler)
+		{
+			StartIdleSweep(2.0f);
+		}
+	}
+	else
+	{
+		// Also without a relevant target, the turret holds the aim of the server
+		SetState(ETurretState::Engaging);
+
+		if (CurrentTarget)
+		{
+			// The turret has been rotating toward the target on the server since the state was written
+			const float Latency = FMath::Clamp(GetServerWorldTime(GetWorld()) - AimState.ServerTime, 0.0f, MaxAimExtrapolationTime);
+			if (UTurretManagerSubsystem* TurretManager = GetWorld()->GetSubsystem<UTurretManagerSubsystem>())
+			{
+				TurretManager->AdvanceTurret(this, Latency);
+			}
+		}
+	}
+}
+
+void ATurret::RequestCanSeeTargets(const TArray<AActor*>& Targets)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_CanSeeTarget);
+	TURRETAI_PROFILE_SCOPE(Traces);
+
 	FCollisionQueryParams CollisionParams;
 	CollisionParams.AddIgnoredActor(this);
+
+	const FVector StartLocation = BaseMesh->GetSocketLocation("ConnectionSocket");
 	
-	FHitResult HitResult;
-	if (GetWorld()->LineTraceSingleByProfile(HitResult, BaseMesh->GetSocketLocation("ConnectionSocket"), Target->GetActorLocation(), UCollisionProfile::Pawn_ProfileName, CollisionParams))
+	CanSeeTraceHandles.Reset(Targets.Num());
+	CanSeeCandidates.Reset(Targets.Num());
+	CanSeeResults.Reset(Targets.Num());
+	NumPendingCanSeeTraces = Targets.Num();
+
+	FTurretStats::AddTraces(Targets.Num());
+
+	for (AActor* Target : Targets)
 	{
-		return HitResult.GetActor() == Target;
+		CanSeeTraceHandles.Add(GetWorld()->AsyncLineTraceByProfile(EAsyncTraceType::Single, StartLocation, Target->GetActorLocation(),
+			UCollisionProfile::Pawn_ProfileName, CollisionParams, &CanSeeTargetDelegate));
+		CanSeeCandidates.Add(Target);
+		CanSeeResults.Add(0);
 	}
-	
-	return false;
 }
 
-bool ATurret::CanHitTarget(AActor* Target) const
+void ATurret::OnCanSeeTargetTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
 {
-	FVector StartLocation = BarrelMesh->GetSocketLocation("ProjectileSocket");
-	FVector EndLocation = StartLocation + BarrelMesh->GetForwardVector() * (Detector->GetUnscaledSphereRadius() + 100.0f);
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_CanSeeTarget);
+	TURRETAI_PROFILE_SCOPE(Traces);
+
+	// Ignore the results of the previous searches
+	const int32 Index = CanSeeTraceHandles.IndexOfByKey(TraceHandle);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	CanSeeResults[Index] = IsTargetHit(TraceDatum, CanSeeCandidates[Index].Get());
 	
+	if (--NumPendingCanSeeTraces > 0)
+	{
+		return;
+	}
+
+	CanSeeTraceHandles.Reset();
+
+	// Keep the same priority as the candidates order
+	for (int32 i = 0; i < CanSeeCandidates.Num(); ++i)
+	{
+		AActor* NewTarget = CanSeeCandidates[i].Get();
+		if (CanSeeResults[i] && IsValid(NewTarget))
+		{
+			SetCurrentTarget(NewTarget);
+			StartFireTurret();
+			return;
+		}
+	}
+
+	if (RequestNextCanSeeTargets())
+	{
+		return;
+	}
+
+	// Retry
+	EnterDormancy();
+	ScheduleTask(ETurretTask::Search, 0.5f);
+}
+
+bool ATurret::RequestNextCanSeeTargets()
+{
+	TargetCandidates.Reset();
+	while (NextVisibilityFallback < VisibilityFallbacks.Num() && TargetCandidates.Num() < TargetScoring.MaxVisibilityChecks)
+	{
+		if (AActor* Candidate = VisibilityFallbacks[NextVisibilityFallback++].Get())
+		{
+			TargetCandidates.Add(Candidate);
+		}
+	}
+
+	if (TargetCandidates.IsEmpty())
+	{
+		return false;
+	}
+
+	RequestCanSeeTargets(TargetCandidates);
+	return true;
+}
+
+void ATurret::RequestCanHitTarget(bool bDropTargetOnMiss)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_CanHitTarget);
+	TURRETAI_PROFILE_SCOPE(Traces);
+
+	CanHitTraceHandles.Reset();
+
+	const FVector StartLocation = BarrelMesh->GetSocketLocation("ProjectileSocket");
+	const FVector Direction = BarrelMesh->GetForwardVector();
+	FVector AimLocation = FVector::ZeroVector;
+	float Distance = Detector->GetUnscaledSphereRadius() + 100.0f;
+	uint32 UserData = bDropTargetOnMiss ? CanHitDropTargetFlag : 0;
+
+	// Non-homing projectiles are fired at the predicted location of the target, so the barrel is checked against that location
+	if (CurrentTarget && GetTurretInfo().HasFlag(ETurretAbility::Homing) == false && ProjectileSpeed > 0.0f)
+	{
+		// The lead and the aim check are computed for all turrets in parallel by the turret manager
+		bool bAimed;
+		const UTurretManagerSubsystem* TurretManager = GetWorld()->GetSubsystem<UTurretManagerSubsystem>();
+		if (TurretManager == nullptr || TurretManager->GetAimResult(this, AimLocation, bAimed) == false)
+		{
+			AimLocation = GetAimLocation();
+			bAimed = FVector::DotProduct((AimLocation - StartLocation).GetSafeNormal(), Direction) >= FMath::Cos(FMath::DegreesToRadians(LeadAimTolerance));
+		}
+
+		if (bAimed == false)
+		{
+			HandleCanHitResult(false, bDropTargetOnMiss);
+			return;
+		}
+
+		Distance = FVector::Distance(StartLocation, AimLocation);
+		UserData |= CanHitPredictedFlag;
+	}
+
+	// The path is the same as the last check while the target and the aim don't change
+	const float Time = GetWorld()->GetTimeSeconds();
+	if (CanHitCache.Target == CurrentTarget && Time - CanHitCache.Time <= CanHitCacheDuration
+		&& FVector::DotProduct(CanHitCache.Direction, Direction) >= FMath::Cos(FMath::DegreesToRadians(CanHitCacheAngle))
+		&& FVector::DistSquared(CanHitCache.AimLocation, AimLocation) <= FMath::Square(ProjectileRadius))
+	{
+		HandleCanHitResult(CanHitCache.bCanHit, bDropTargetOnMiss);
+		return;
+	}
+
+	CanHitCache.Target = CurrentTarget;
+	CanHitCache.Direction = Direction;
+	CanHitCache.AimLocation = AimLocation;
+	CanHitCache.Time = -UE_BIG_NUMBER;
+
+	// Predicted shots that are affected by gravity fly an arc, the path ends at the aim location so cover behind it doesn't block the shot
+	const bool bArc = (UserData & CanHitPredictedFlag) != 0 && ProjectileGravityZ != 0.0f;
+	const int32 NumSegments = bArc ? FMath::Max(NumArcSegments, 1) : 1;
+	const FVector Velocity = Direction * ProjectileSpeed;
+
+	// Gravity doesn't change the horizontal speed, so the time of flight to the aim location follows from the horizontal distance
+	float FlightTime = 0.0f;
+	if (bArc)
+	{
+		const float HorizontalSpeed = Velocity.Size2D();
+		FlightTime = HorizontalSpeed > KINDA_SMALL_NUMBER ? FVector::Dist2D(StartLocation, AimLocation) / HorizontalSpeed : Distance / ProjectileSpeed;
+	}
+
 	FCollisionQueryParams CollisionParams;
 	CollisionParams.AddIgnoredActor(this);
 	CollisionParams.MobilityType = EQueryMobilityType::Dynamic;
 
-	// NOTE: For better results, the sphere radius should match the projectile radius
-	FHitResult HitResult;
-	if (GetWorld()->SweepSingleByProfile(HitResult, StartLocation, EndLocation, FQuat::Identity, UCollisionProfile::Pawn_ProfileName, FCollisionShape::MakeSphere(50.0f), CollisionParams) &&
-		HitResult.GetActor() == Target)
+	const FCollisionShape CollisionShape = FCollisionShape::MakeSphere(ProjectileRadius);
+
+	CanHitResults.Reset(NumSegments);
+	NumPendingCanHitTraces = NumSegments;
+
+	FTurretStats::AddTraces(NumSegments);
+
+	FVector SegmentStart = StartLocation;
+	for (int32 i = 1; i <= NumSegments; ++i)
+	{
+		FVector SegmentEnd = StartLocation + Direction * Distance;
+		if (bArc)
+		{
+			SegmentEnd = i == NumSegments ? AimLocation : FTurretAimSolver::GetArcLocation(StartLocation, Velocity, ProjectileGravityZ, FlightTime * i / NumSegments);
+		}
+
+		CanHitTraceHandles.Add(GetWorld()->AsyncSweepByProfile(EAsyncTraceType::Single, SegmentStart, SegmentEnd, FQuat::Identity, UCollisionProfile::Pawn_ProfileName,
+			CollisionShape, CollisionParams, &CanHitTargetDelegate, UserData));
+		CanHitResults.Add(CanHitSegmentClear);
+
+		SegmentStart = SegmentEnd;
+	}
+}
+
+void ATurret::OnCanHitTargetTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_CanHitTarget);
+	TURRETAI_PROFILE_SCOPE(Traces);
+
+	// Ignore the results of the previous checks
+	const int32 Index = CanHitTraceHandles.IndexOfByKey(TraceHandle);
+	if (Index == INDEX_NONE)
 	{
-		return true;
+		return;
+	}
+
+	if (const FHitResult* BlockingHit = FHitResult::GetFirstBlockingHit(TraceDatum.OutHits))
+	{
+		CanHitResults[Index] = CurrentTarget && BlockingHit->GetActor() == CurrentTarget ? CanHitSegmentTarget : CanHitSegmentBlocked;
+	}
+
+	if (--NumPendingCanHitTraces > 0)
+	{
+		return;
+	}
+
+	CanHitTraceHandles.Reset();
+
+	// The target may have been changed or lost while the trace was pending
+	if (CurrentTarget == nullptr || UTurretSchedulerSubsystem::IsScheduled(this, ETurretTask::Fire) == false)
+	{
+		return;
+	}
+
+	// The first segment that is blocked decides, the target of a predicted shot is not on the path yet, so a clear path is enough
+	bool bCanHit = (TraceDatum.UserData & CanHitPredictedFlag) != 0;
+	for (const uint8 Result : CanHitResults)
+	{
+		if (Result != CanHitSegmentClear)
+		{
+			bCanHit = Result == CanHitSegmentTarget;
+			break;
+		}
+	}
+
+	CanHitCache.bCanHit = bCanHit;
+	CanHitCache.Time = GetWorld()->GetTimeSeconds();
+
+	HandleCanHitResult(bCanHit, (TraceDatum.UserData & CanHitDropTargetFlag) != 0);
+}
+
+void ATurret::HandleCanHitResult(bool bCanHit, bool bDropTargetOnMiss)
+{
+	if (bCanHit)
+	{
+		HandleFireTurret();
+	}
+	else if (bDropTargetOnMiss)
+	{
+		CancelTask(ETurretTask::Fire);
+		FindNewTarget();
+	}
+}
+
+FVector ATurret::GetAimLocation() const
+{
+	if (CurrentTarget == nullptr)
+	{
+		return FVector::ZeroVector;
+	}
+
+	const FVector TargetLocation = CurrentTarget->GetActorLocation();
+
+	// Homing projectiles follow the target, so there is no need to lead it
+	if (GetTurretInfo().HasFlag(ETurretAbility::Homing))
+	{
+		return TargetLocation;
+	}
+
+	FVector AimLocation;
+	float TimeOfFlight;
+	FTurretAimSolver::SolveIntercept(BarrelMesh->GetSocketLocation("ProjectileSocket"), TargetLocation, CurrentTarget->GetVelocity(), ProjectileSpeed, ProjectileGravityZ, AimLocation, TimeOfFlight);
+	return AimLocation;
+}
+
+bool ATurret::IsTargetHit(const FTraceDatum& TraceDatum, const AActor* Target)
+{
+	if (Target == nullptr)
+	{
+		return false;
+	}
+
+	for (const FHitResult& HitResult : TraceDatum.OutHits)
+	{
+		if (HitResult.bBlockingHit)
+		{
+			return HitResult.GetActor() == Target;
+		}
 	}
 	
 	return false;
 }
 
-void ATurret::HealthChanged()
+void ATurret::OnHealthChanged(UHealthComponent* Component, float Delta, float NewHealth)
 {
-	if (HealthComp->CurrentHealth <= 0.0f)
+	if (NewHealth <= 0.0f)
 	{
 		Destroy();
+		return;
 	}
+
+	// Dormant turrets don't send the new health otherwise
+	FlushNetDormancy();
 }
 
 void ATurret::Destroyed()
 {
+	SetState(ETurretState::Destroyed);
+
 	UWorld* MyWorld = GetWorld();
-	if (MyWorld->HasBegunPlay())
+	if (IsDestroyedInPlay())
 	{
-		FFXSystemSpawnParameters SpawnParams;
-		SpawnParams.WorldContextObject = MyWorld;
-		SpawnParams.SystemTemplate = DestroyParticleLoaded;
-		SpawnParams.Location = BaseMesh->GetSocketLocation("ConnectionSocket");
-		UNiagaraFunctionLibrary::SpawnSystemAtLocationWithParams(SpawnParams);
-		
-		UGameplayStatics::SpawnSoundAtLocation(MyWorld, DestroySoundLoaded, BaseMesh->GetComponentLocation());
+		// Destruction is rare and noticeable, it is never dropped by the FX budget
+		if (UTurretFXSubsystem* FXSubsystem = MyWorld->GetSubsystem<UTurretFXSubsystem>())
+		{
+			FXSubsystem->RequestFX(DestroyParticleLoaded, DestroySoundLoaded, BaseMesh->GetSocketLocation("ConnectionSocket"),
+				FRotator::ZeroRotator, FVector::OneVector, false);
+		}
 		
-		// Spawn the turret base
-		const ADestroyedStructure* NewStructure = Cast<ADestroyedStructure>(MyWorld->SpawnActor(ADestroyedStructure::StaticClass(), &BaseMesh->GetComponentTransform()));
-		NewStructure->Initialize(BaseMesh->GetStaticMesh(), BaseMesh->GetMaterials(), BaseMesh->GetLinearDamping(), BaseMesh->GetAngularDamping());
-	
-		// Spawn the turret barrel
-		NewStructure = Cast<ADestroyedStructure>(MyWorld->SpawnActor(ADestroyedStructure::StaticClass(), &BarrelMesh->GetComponentTransform()));
-		NewStructure->Initialize(BarrelMesh->GetStaticMesh(), BarrelMesh->GetMaterials(), BarrelMesh->GetLinearDamping(), BarrelMesh->GetAngularDamping());
+		// Spawn the turret base and the turret barrel
+		if (UTurretDebrisSubsystem* DebrisSubsystem = MyWorld->GetSubsystem<UTurretDebrisSubsystem>())
+		{
+			DebrisSubsystem->SpawnDebris(BaseMesh);
+			DebrisSubsystem->SpawnDebris(BarrelMesh);
+		}
 	}
 
 	Super::Destroyed();
 }
+
+void ATurret::TornOff()
+{
+	Super::TornOff();
+
+	// The proxy of the client takes over when the actor is gone
+	if (bDemotedToProxy)
+	{
+		Destroy();
+	}
+}
+
+bool ATurret::IsDestroyedInPlay() const
+{
+	return GetWorld()->HasBegunPlay() && bDemotedToProxy == false;
+}
@@ -0,0 +1,40 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "TurretBenchmarkTarget.h"
+
+#include "Components/SphereComponent.h"
+#include "Engine/CollisionProfile.h"
+
+ATurretBenchmarkTarget::ATurretBenchmarkTarget()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	bReplicates = false;
+	
+	Collision = CreateDefaultSubobject<USphereComponent>(TEXT("Collision"));
+	RootComponent = Collision;
+	Collision->InitSphereRadius(50.0f);
+	Collision->SetCollisionProfileName(UCollisionProfile::Pawn_ProfileName);
+	Collision->SetGenerateOverlapEvents(true);
+}
+
+void ATurretBenchmarkTarget::InitializePath(const FVector& InCenter, float InRadius, float InSpeed, float InPhase)
+{
+	Center = InCenter;
+	Radius = FMath::Max(InRadius, 1.0f);
+	AngularSpeed = InSpeed / Radius;
+	Angle = InPhase;
+}
+
+void ATurretBenchmarkTarget::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	Angle = FMath::UnwindRadians(Angle + AngularSpeed * DeltaSeconds);
+
+	float Sin, Cos;
+	FMath::SinCos(&Sin, &Cos, Angle);
+	SetActorLocation(Center + FVector(Cos, Sin, 0.0f) * Radius);
+
+	// Moved without a movement component, the velocity is used by the turrets to lead the target
+	Collision->ComponentVelocity = FVector(-Sin, Cos, 0.0f) * AngularSpeed * Radius;
+}
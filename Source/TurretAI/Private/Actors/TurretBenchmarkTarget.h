@@ -0,0 +1,45 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Pawn.h"
+#include "TurretBenchmarkTarget.generated.h"
+
+class USphereComponent;
+
+/**
+ * Target of the combat benchmark, moves around a circle so the turrets have to lead and switch targets
+ */
+UCLASS(NotBlueprintable, NotPlaceable, Transient)
+class ATurretBenchmarkTarget : public APawn
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<USphereComponent> Collision;
+
+// Functions
+public:
+	ATurretBenchmarkTarget();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/**
+	* Setting the path of the target
+	* @param	InSpeed		Speed along the circle, negative values move clockwise
+	* @param	InPhase		Start angle on the circle in radians
+	*/
+	void InitializePath(const FVector& InCenter, float InRadius, float InSpeed, float InPhase);
+
+// Variables
+private:
+	FVector Center = FVector::ZeroVector;
+
+	float Radius = 0.0f;
+
+	/** Angular speed in radians per second */
+	float AngularSpeed = 0.0f;
+
+	float Angle = 0.0f;
+};
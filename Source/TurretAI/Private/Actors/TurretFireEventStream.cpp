@@ -0,0 +1,68 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "TurretFireEventStream.h"
+
+#include "Actors/Turret.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+#include "Subsystems/TurretFireEventSubsystem.h"
+
+void FTurretFireEvent::PostReplicatedAdd(const FTurretFireEventArray& InArraySerializer)
+{
+	// The turret is not relevant to this client
+	if (Turret == nullptr)
+	{
+		return;
+	}
+
+	// Old shots are received when the stream becomes relevant again, they should not be played
+	const AGameStateBase* GameState = Turret->GetWorld()->GetGameState();
+	if (GameState && GameState->GetServerWorldTimeSeconds() - ServerTime > GetDefault<UTurretFireEventSubsystem>()->GetMaxEventAge())
+	{
+		return;
+	}
+
+	Turret->PlayFireEvent(Seed);
+}
+
+ATurretFireEventStream::ATurretFireEventStream()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	bReplicates = true;
+	bOnlyRelevantToOwner = true;
+	bAlwaysRelevant = false;
+	NetUpdateFrequency = 30.0f;
+	SetReplicatingMovement(false);
+}
+
+void ATurretFireEventStream::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ATurretFireEventStream, FireEvents);
+}
+
+void ATurretFireEventStream::AddEvent(ATurret* Turret, uint16 Seed, float ServerTime, float MaxEventAge, int32 MaxEvents)
+{
+	TArray<FTurretFireEvent>& Events = FireEvents.Events;
+
+	// Events are added in time order, so the old ones are at the front
+	int32 NumExpired = 0;
+	while (NumExpired < Events.Num() && (ServerTime - Events[NumExpired].ServerTime > MaxEventAge || Events.Num() - NumExpired >= MaxEvents))
+	{
+		++NumExpired;
+	}
+
+	if (NumExpired > 0)
+	{
+		Events.RemoveAt(0, NumExpired, false);
+		FireEvents.MarkArrayDirty();
+	}
+
+	FTurretFireEvent& Event = Events.AddDefaulted_GetRef();
+	Event.Turret = Turret;
+	Event.Seed = Seed;
+	Event.ServerTime = ServerTime;
+	FireEvents.MarkItemDirty(Event);
+}
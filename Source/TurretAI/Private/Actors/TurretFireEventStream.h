@@ -0,0 +1,86 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "TurretFireEventStream.generated.h"
+
+class ATurret;
+class ATurretFireEventStream;
+
+/** One shot of a turret, clients rebuild the shot from the seed */
+USTRUCT()
+struct FTurretFireEvent : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<ATurret> Turret;
+
+	/** Seed of the random values of the shot, such as the shotgun spread */
+	UPROPERTY()
+	uint16 Seed;
+
+	/** Server world time of the shot */
+	UPROPERTY()
+	float ServerTime;
+
+	FTurretFireEvent()
+		: Turret(nullptr)
+		, Seed(0)
+		, ServerTime(0.0f)
+	{}
+
+	void PostReplicatedAdd(const struct FTurretFireEventArray& InArraySerializer);
+};
+
+/** Recent shots of the turrets that are relevant to one connection, oldest first */
+USTRUCT()
+struct FTurretFireEventArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FTurretFireEvent> Events;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FTurretFireEvent, FTurretFireEventArray>(Events, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FTurretFireEventArray> : public TStructOpsTypeTraitsBase2<FTurretFireEventArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * Replicates the shots of all turrets to one connection, so the shots of many turrets are packed into each net update
+ * instead of sending a multicast RPC per shot. Owned by the player controller of the connection.
+ */
+UCLASS(NotPlaceable, Transient)
+class ATurretFireEventStream : public AInfo
+{
+	GENERATED_BODY()
+
+// Functions
+public:
+	ATurretFireEventStream();
+
+	/**
+	* Adding a shot to the stream, shots that are older than the max age or over the max count are removed
+	* @param	ServerTime	Server world time of the shot
+	*/
+	void AddEvent(ATurret* Turret, uint16 Seed, float ServerTime, float MaxEventAge, int32 MaxEvents);
+
+// Variables
+private:
+	UPROPERTY(Replicated)
+	FTurretFireEventArray FireEvents;
+};
@@ -0,0 +1,84 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "TurretProxyAimStream.h"
+
+#include "Actors/Turret.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+#include "Subsystems/TurretProxySubsystem.h"
+
+static UTurretProxySubsystem* GetProxySubsystem(const FTurretProxyAimArray& ProxyAims)
+{
+	const UWorld* World = ProxyAims.Owner ? ProxyAims.Owner->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UTurretProxySubsystem>() : nullptr;
+}
+
+void FTurretProxyAim::PostReplicatedAdd(const FTurretProxyAimArray& InArraySerializer)
+{
+	if (UTurretProxySubsystem* ProxySubsystem = GetProxySubsystem(InArraySerializer))
+	{
+		ProxySubsystem->AddReplicatedProxy(ProxyId, TurretClass, Transform, AimState, Turret);
+	}
+}
+
+void FTurretProxyAim::PostReplicatedChange(const FTurretProxyAimArray& InArraySerializer)
+{
+	if (UTurretProxySubsystem* ProxySubsystem = GetProxySubsystem(InArraySerializer))
+	{
+		ProxySubsystem->ApplyProxyAim(ProxyId, AimState, Turret);
+	}
+}
+
+void FTurretProxyAim::PreReplicatedRemove(const FTurretProxyAimArray& InArraySerializer)
+{
+	// The proxy was destroyed on the server
+	if (UTurretProxySubsystem* ProxySubsystem = GetProxySubsystem(InArraySerializer))
+	{
+		ProxySubsystem->RemoveProxy(ProxyId);
+	}
+}
+
+ATurretProxyAimStream::ATurretProxyAimStream()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	NetUpdateFrequency = 10.0f;
+	SetReplicatingMovement(false);
+
+	ProxyAims.Owner = this;
+}
+
+void ATurretProxyAimStream::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ATurretProxyAimStream, ProxyAims);
+}
+
+int32 ATurretProxyAimStream::AddAim(int32 ProxyId, TSubclassOf<ATurret> TurretClass, const FTransform& Transform)
+{
+	const int32 AimIndex = ProxyAims.Aims.AddDefaulted();
+
+	FTurretProxyAim& Aim = ProxyAims.Aims[AimIndex];
+	Aim.ProxyId = ProxyId;
+	Aim.TurretClass = TurretClass;
+	Aim.Transform = Transform;
+	ProxyAims.MarkItemDirty(Aim);
+
+	return AimIndex;
+}
+
+void ATurretProxyAimStream::SetAim(int32 AimIndex, const FTurretAimState& AimState, ATurret* Turret)
+{
+	FTurretProxyAim& Aim = ProxyAims.Aims[AimIndex];
+	Aim.AimState = AimState;
+	Aim.Turret = Turret;
+	ProxyAims.MarkItemDirty(Aim);
+}
+
+void ATurretProxyAimStream::RemoveAim(int32 AimIndex)
+{
+	ProxyAims.Aims.RemoveAtSwap(AimIndex, 1, false);
+	ProxyAims.MarkArrayDirty();
+}
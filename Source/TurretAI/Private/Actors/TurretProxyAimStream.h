@@ -0,0 +1,106 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "Types/TurretAimState.h"
+#include "TurretProxyAimStream.generated.h"
+
+class ATurret;
+class ATurretProxyAimStream;
+
+/** One proxy turret, the clients create the proxy when it is added and the aim only changes when the proxy gains or loses a target */
+USTRUCT()
+struct FTurretProxyAim : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/** Given by the server, the clients find their proxy by this id */
+	UPROPERTY()
+	int32 ProxyId;
+
+	UPROPERTY()
+	TSubclassOf<ATurret> TurretClass;
+
+	UPROPERTY()
+	FTransform Transform;
+
+	UPROPERTY()
+	FTurretAimState AimState;
+
+	/** Turret actor of the promoted proxy, the clients hide the proxy while this actor is relevant to them */
+	UPROPERTY()
+	TObjectPtr<ATurret> Turret;
+
+	FTurretProxyAim()
+		: ProxyId(INDEX_NONE)
+		, Turret(nullptr)
+	{}
+
+	void PostReplicatedAdd(const struct FTurretProxyAimArray& InArraySerializer);
+	void PostReplicatedChange(const struct FTurretProxyAimArray& InArraySerializer);
+	void PreReplicatedRemove(const struct FTurretProxyAimArray& InArraySerializer);
+};
+
+/** All proxies of the world */
+USTRUCT()
+struct FTurretProxyAimArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FTurretProxyAim> Aims;
+
+	/** Stream that replicates the array, the clients apply the proxies to the proxy subsystem of its world */
+	ATurretProxyAimStream* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FTurretProxyAim, FTurretProxyAimArray>(Aims, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FTurretProxyAimArray> : public TStructOpsTypeTraitsBase2<FTurretProxyAimArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * Replicates the proxy turrets, which have no actor of their own. Clients that join late receive all proxies the server still has.
+ * Only the target changes are sent, and the clients turn the proxies toward the targets themselves like the turret actors.
+ */
+UCLASS(NotPlaceable, Transient)
+class ATurretProxyAimStream : public AInfo
+{
+	GENERATED_BODY()
+
+// Functions
+public:
+	ATurretProxyAimStream();
+
+	/**
+	* Adding a new proxy, the clients create their proxy from the class and the transform
+	* @return	Index of the aim in the stream
+	*/
+	int32 AddAim(int32 ProxyId, TSubclassOf<ATurret> TurretClass, const FTransform& Transform);
+
+	void SetAim(int32 AimIndex, const FTurretAimState& AimState, ATurret* Turret);
+
+	/** Removing the aim, the last aim is moved to its index */
+	void RemoveAim(int32 AimIndex);
+
+	const FTurretProxyAim& GetAim(int32 AimIndex) const { return ProxyAims.Aims[AimIndex]; }
+
+	int32 GetNumAims() const { return ProxyAims.Aims.Num(); }
+
+// Variables
+private:
+	UPROPERTY(Replicated)
+	FTurretProxyAimArray ProxyAims;
+};
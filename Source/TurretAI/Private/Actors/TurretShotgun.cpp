@@ -3,41 +3,31 @@
 #include "Actors/TurretShotgun.h"
 
 #include "Components/StaticMeshComponent.h"
+#include "Types/TurretRandom.h"
 
-void ATurretShotgun::HandleFireTurret()
+void ATurretShotgun::PlayFireEvent(uint16 Seed)
 {
-	// Calculating direction for projectiles based on the Accuracy Offset
-	TArray<FRotator> Rotations;
-	Rotations.Reserve(3);
-	
-	const FRotator SocketRotation = BarrelMesh->GetSocketRotation("ProjectileSocket");
-
-	uint8 i = 0;
-	while (i < NumOfShots)
-	{
-		FRotator NewRotation;
-			
-		NewRotation.Pitch	= SocketRotation.Pitch	+ FMath::RandRange(ShotgunSpread * -1.0f, ShotgunSpread);
-		NewRotation.Yaw		= SocketRotation.Yaw	+ FMath::RandRange(ShotgunSpread * -1.0f, ShotgunSpread);
-		NewRotation.Roll	= SocketRotation.Roll	+ FMath::RandRange(ShotgunSpread * -1.0f, ShotgunSpread);
-
-		Rotations.Add(NewRotation);
-		++i;
-	}
-	
-	MulticastFireShotgunTurret(Rotations);
-}
-
-void ATurretShotgun::MulticastFireShotgunTurret_Implementation(const TArray<FRotator>& Rotations)
-{
-	if (CurrentTarget == nullptr)
+	if (CanPlayFireEvent() == false)
 	{
 		return;
 	}
-	
+
 	FTransform NewTransform = BarrelMesh->GetSocketTransform("ProjectileSocket");
-	for (FRotator NewRotation : Rotations)
+	const FRotator SocketRotation = NewTransform.Rotator();
+
+	const UTurretArchetype* TurretArchetype = GetArchetype();
+	const uint8 NumShots = TurretArchetype ? TurretArchetype->NumOfShots : NumOfShots;
+	const float Spread = TurretArchetype ? TurretArchetype->ShotgunSpread : ShotgunSpread;
+
+	// Calculating direction for projectiles based on the Accuracy Offset
+	TArray<FRotator, TInlineAllocator<16>> SpreadOffsets;
+	SpreadOffsets.SetNumUninitialized(NumShots);
+	FTurretRandom::MakeSpreadOffsets(Seed, Spread, SpreadOffsets);
+
+	for (uint8 i = 0; i < NumShots; ++i)
 	{
+		const FRotator NewRotation = SocketRotation + SpreadOffsets[i];
+
 		NewTransform.SetRotation(NewRotation.Quaternion());
 		
 		SpawnProjectile(NewTransform);
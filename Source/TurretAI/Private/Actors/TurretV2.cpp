@@ -2,8 +2,8 @@
 
 #include "Actors/TurretV2.h"
 
-#include "DestroyedStructure.h"
 #include "Engine/World.h"
+#include "Subsystems/TurretDebrisSubsystem.h"
 
 ATurretV2::ATurretV2()
 {
@@ -16,25 +16,16 @@ ATurretV2::ATurretV2()
 	BarrelMesh->SetupAttachment(TurretMesh);
 }
 
-void ATurretV2::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-	FRotator NewRotation = CalculateRotation(TurretMesh, DeltaTime);
-	TurretMesh->SetRelativeRotation(FRotator(0.0f, NewRotation.Yaw, 0.0f));
-
-	NewRotation = CalculateRotation(BarrelMesh, DeltaTime);
-	BarrelMesh->SetRelativeRotation(FRotator(FMath::ClampAngle(NewRotation.Pitch, TurretInfo.MinPitch, TurretInfo.MaxPitch), 0.0f, 0.0f));
-}
-
 void ATurretV2::Destroyed()
 {
 	UWorld* MyWorld = GetWorld();
-	if (MyWorld->HasBegunPlay())
+	if (IsDestroyedInPlay())
 	{
 		// Spawn the cannon turret
-		const ADestroyedStructure* NewStructure = Cast<ADestroyedStructure>(MyWorld->SpawnActor(ADestroyedStructure::StaticClass(), &TurretMesh->GetComponentTransform()));
-		NewStructure->Initialize(TurretMesh->GetStaticMesh(), TurretMesh->GetMaterials(), TurretMesh->GetLinearDamping(), TurretMesh->GetAngularDamping());
+		if (UTurretDebrisSubsystem* DebrisSubsystem = MyWorld->GetSubsystem<UTurretDebrisSubsystem>())
+		{
+			DebrisSubsystem->SpawnDebris(TurretMesh);
+		}
 	}
 
 	Super::Destroyed();
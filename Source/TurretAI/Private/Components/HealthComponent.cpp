@@ -2,28 +2,56 @@
 
 #include "Components/HealthComponent.h"
 
-#include "Interfaces/GameplayInterface.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
+
+static float GetServerWorldTime(const UWorld* World)
+{
+	const AGameStateBase* GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+static uint16 QuantizeRatio(float Value, float MaxValue)
+{
+	return MaxValue > 0.0f ? static_cast<uint16>(FMath::RoundToInt32(FMath::Clamp(Value / MaxValue, 0.0f, 1.0f) * MAX_uint16)) : 0;
+}
 
 UHealthComponent::UHealthComponent()
 {
-	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.bCanEverTick = false;
+	bWantsInitializeComponent = true;
+	SetIsReplicatedByDefault(true);
 
 	// Initialize variables
 	bIsAlive = true;
-	CurrentHealth = DefaultHealth;
+	bDamagePending = false;
+}
+
+void UHealthComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UHealthComponent, HealthState, Params);
+}
+
+void UHealthComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	BaseHealth = DefaultHealth;
+	BaseShield = Modifiers.MaxShield;
 }
 
 void UHealthComponent::Activate(bool bReset)
 {
 	Super::Activate(bReset);
 
-	if (IGameplayInterface* GameplayInterface = Cast<IGameplayInterface>(GetOwner()))
-	{
-		OwnerInterface.SetObject(GetOwner());
-		OwnerInterface.SetInterface(GameplayInterface);
-		
-		GetOwner()->OnTakeAnyDamage.AddDynamic(this, &UHealthComponent::OwnerTakeDamage);
-	}
+	GetOwner()->OnTakeAnyDamage.AddUniqueDynamic(this, &UHealthComponent::OwnerTakeDamage);
 }
 
 void UHealthComponent::OwnerTakeDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser)
@@ -32,10 +60,85 @@ void UHealthComponent::OwnerTakeDamage(AActor* DamagedActor, float Damage, const
 	{
 		return;
 	}
-	
-	CurrentHealth -= Damage;
-	
-	bIsAlive = CurrentHealth > 0.0f;
 
-	OwnerInterface->HealthChanged();
+	// Armor is applied to each hit, the rest of the modifiers to the sum
+	PendingDamage += FMath::Max(Damage - Modifiers.Armor, 0.0f);
+
+	if (bDamagePending == false)
+	{
+		bDamagePending = true;
+		GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UHealthComponent::ApplyPendingDamage);
+	}
+}
+
+void UHealthComponent::ApplyPendingDamage()
+{
+	bDamagePending = false;
+
+	const float Damage = PendingDamage * (1.0f - Modifiers.Resistance);
+	PendingDamage = 0.0f;
+
+	if (bIsAlive == false || Damage <= 0.0f)
+	{
+		return;
+	}
+
+	const float OldHealth = GetHealth();
+	const float OldShield = GetShield();
+	const float AbsorbedDamage = FMath::Min(OldShield, Damage);
+	const float NewHealth = FMath::Max(OldHealth - (Damage - AbsorbedDamage), 0.0f);
+
+	SetHealthState(NewHealth, OldShield - AbsorbedDamage);
+
+	OnHealthChanged.Broadcast(this, NewHealth - OldHealth, NewHealth);
+}
+
+void UHealthComponent::SetHealthState(float NewHealth, float NewShield)
+{
+	BaseHealth = NewHealth;
+	BaseShield = NewShield;
+	bIsAlive = NewHealth > 0.0f;
+
+	HealthState.Health = QuantizeRatio(NewHealth, DefaultHealth);
+	HealthState.Shield = QuantizeRatio(NewShield, Modifiers.MaxShield);
+	HealthState.ChangeTime = GetServerWorldTime(GetWorld());
+	MARK_PROPERTY_DIRTY_FROM_NAME(UHealthComponent, HealthState, this);
+}
+
+void UHealthComponent::OnRep_HealthState()
+{
+	const float OldHealth = GetHealth();
+
+	BaseHealth = DefaultHealth * HealthState.Health / MAX_uint16;
+	BaseShield = Modifiers.MaxShield * HealthState.Shield / MAX_uint16;
+	bIsAlive = HealthState.Health > 0;
+
+	const float NewHealth = GetHealth();
+	OnHealthChanged.Broadcast(this, NewHealth - OldHealth, NewHealth);
+}
+
+float UHealthComponent::GetRegenTime(float Delay) const
+{
+	const UWorld* World = GetWorld();
+	return World ? FMath::Max(GetServerWorldTime(World) - HealthState.ChangeTime - Delay, 0.0f) : 0.0f;
+}
+
+float UHealthComponent::GetHealth() const
+{
+	if (bIsAlive == false || Modifiers.HealthRegenRate <= 0.0f)
+	{
+		return BaseHealth;
+	}
+
+	return FMath::Min(BaseHealth + Modifiers.HealthRegenRate * GetRegenTime(Modifiers.HealthRegenDelay), DefaultHealth);
+}
+
+float UHealthComponent::GetShield() const
+{
+	if (bIsAlive == false || Modifiers.ShieldRegenRate <= 0.0f)
+	{
+		return BaseShield;
+	}
+
+	return FMath::Min(BaseShield + Modifiers.ShieldRegenRate * GetRegenTime(Modifiers.ShieldRegenDelay), Modifiers.MaxShield);
 }
@@ -6,6 +6,65 @@
 #include "Components/ActorComponent.h"
 #include "HealthComponent.generated.h"
 
+class UHealthComponent;
+
+/** Broadcast once per frame with the sum of the health changes of that frame */
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnHealthChangedSignature, UHealthComponent* /* HealthComp */, float /* Delta */, float /* NewHealth */);
+
+/**
+ * Data-driven damage modifiers, the regeneration is evaluated when the health is read instead of ticking
+ */
+USTRUCT(BlueprintType)
+struct FHealthModifiers
+{
+	GENERATED_BODY()
+
+	/** Shield that absorbs the damage before the health */
+	UPROPERTY(EditAnywhere, Category = "Default", meta = (ClampMin = 0.0, UIMin = 0.0))
+	float MaxShield = 0.0f;
+
+	/** Shield points per second after ShieldRegenDelay seconds without damage */
+	UPROPERTY(EditAnywhere, Category = "Default", meta = (ClampMin = 0.0, UIMin = 0.0))
+	float ShieldRegenRate = 0.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Default", meta = (ClampMin = 0.0, UIMin = 0.0))
+	float ShieldRegenDelay = 3.0f;
+
+	/** Flat damage reduction of each hit */
+	UPROPERTY(EditAnywhere, Category = "Default", meta = (ClampMin = 0.0, UIMin = 0.0))
+	float Armor = 0.0f;
+
+	/** Fraction of the damage that is ignored after the armor */
+	UPROPERTY(EditAnywhere, Category = "Default", meta = (ClampMin = 0.0, ClampMax = 1.0, UIMin = 0.0, UIMax = 1.0))
+	float Resistance = 0.0f;
+
+	/** Health points per second after HealthRegenDelay seconds without damage */
+	UPROPERTY(EditAnywhere, Category = "Default", meta = (ClampMin = 0.0, UIMin = 0.0))
+	float HealthRegenRate = 0.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Default", meta = (ClampMin = 0.0, UIMin = 0.0))
+	float HealthRegenDelay = 5.0f;
+};
+
+/**
+ * Replicated health and shield at the last change, quantized to a fraction of their maximum
+ */
+USTRUCT()
+struct FHealthState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint16 Health = MAX_uint16;
+
+	UPROPERTY()
+	uint16 Shield = MAX_uint16;
+
+	/** Server world time of the change, the regeneration starts from this time */
+	UPROPERTY()
+	float ChangeTime = 0.0f;
+};
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class TURRETAI_API UHealthComponent : public UActorComponent
 {
@@ -16,21 +75,60 @@ public:
 	/** Sets default values for this component's properties */
 	UHealthComponent();
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void InitializeComponent() override;
+
 	virtual void Activate(bool bReset) override;
 
+	/** Health with the regeneration since the last change */
+	float GetHealth() const;
+
+	/** Shield with the regeneration since the last change */
+	float GetShield() const;
+
+	float GetMaxHealth() const { return DefaultHealth; }
+
+	bool IsAlive() const { return bIsAlive; }
+
 private:
+	/** Damage is accumulated and applied once on the next tick of the world */
 	UFUNCTION()
 	void OwnerTakeDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser);
 
+	void ApplyPendingDamage();
+
+	/** Storing the evaluated values as the new start of the regeneration */
+	void SetHealthState(float NewHealth, float NewShield);
+
+	UFUNCTION()
+	void OnRep_HealthState();
+
+	/** Seconds of regeneration since the last change */
+	float GetRegenTime(float Delay) const;
+
 // Variables
 public:
 	UPROPERTY(EditAnywhere, Category = "Default", meta = (ClampMin = 0.0, UIMin = 0.0))
 	float DefaultHealth = 100.0f;
 
-	float CurrentHealth = 0.0f;
+	UPROPERTY(EditAnywhere, Category = "Default")
+	FHealthModifiers Modifiers;
+
+	FOnHealthChangedSignature OnHealthChanged;
 
 private:
-	TScriptInterface<class IGameplayInterface> OwnerInterface;
+	/** Only written when the health changes, so the property is pushed instead of compared on each update */
+	UPROPERTY(ReplicatedUsing = OnRep_HealthState)
+	FHealthState HealthState;
+
+	/** Health and shield at the last change */
+	float BaseHealth = 0.0f;
+	float BaseShield = 0.0f;
+
+	/** Damage of the current frame after the armor */
+	float PendingDamage = 0.0f;
 
 	uint8 bIsAlive : 1;
+	uint8 bDamagePending : 1;
 };
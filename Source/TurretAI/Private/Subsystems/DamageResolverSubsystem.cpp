@@ -0,0 +1,220 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/DamageResolverSubsystem.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "Engine/DamageEvents.h"
+#include "Engine/OverlapResult.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/DamageType.h"
+#include "TurretAIProfiling.h"
+
+DECLARE_CYCLE_STAT(TEXT("Resolve Explosions"), STAT_TurretAI_ResolveExplosions, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Explosions"), STAT_TurretAI_Explosions, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Explosion Queries"), STAT_TurretAI_ExplosionQueries, STATGROUP_TurretAI);
+
+/** Damage scale and the closest component of an actor for each explosion of a cluster, the scale is negative when the actor is out of reach */
+using FExplosionScales = TArray<TPair<float, const UPrimitiveComponent*>, TInlineAllocator<8>>;
+
+void UDamageResolverSubsystem::Deinitialize()
+{
+	Explosions.Empty();
+	Clusters.Empty();
+	VictimDamages.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UDamageResolverSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UDamageResolverSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDamageResolverSubsystem, STATGROUP_Tickables);
+}
+
+void UDamageResolverSubsystem::AddExplosion(const FRadialDamageParams& DamageInfo, const FVector& Origin, AController* InstigatorController, AActor* DamageCauser)
+{
+	if (DamageInfo.BaseDamage <= 0.0f || DamageInfo.GetMaxRadius() <= 0.0f)
+	{
+		return;
+	}
+
+	Explosions.Add({ DamageInfo, Origin, InstigatorController, DamageCauser });
+	INC_DWORD_STAT(STAT_TurretAI_Explosions);
+}
+
+void UDamageResolverSubsystem::Tick(float DeltaTime)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_ResolveExplosions);
+	TURRETAI_PROFILE_SCOPE(Damage);
+
+	Super::Tick(DeltaTime);
+
+	if (Explosions.IsEmpty())
+	{
+		return;
+	}
+
+	BuildClusters();
+
+	for (const FExplosionCluster& Cluster : Clusters)
+	{
+		ResolveCluster(Cluster);
+	}
+
+	ApplyVictimDamages();
+
+	Explosions.Reset();
+	Clusters.Reset();
+	VictimDamages.Reset();
+}
+
+void UDamageResolverSubsystem::BuildClusters()
+{
+	for (int32 i = 0; i < Explosions.Num(); ++i)
+	{
+		const FSphere Blast(Explosions[i].Origin, Explosions[i].DamageInfo.GetMaxRadius());
+
+		FExplosionCluster* TargetCluster = nullptr;
+		for (FExplosionCluster& Cluster : Clusters)
+		{
+			if (Cluster.Bounds.Intersects(Blast) == false)
+			{
+				continue;
+			}
+
+			FSphere MergedBounds = Cluster.Bounds;
+			MergedBounds += Blast;
+			if (MergedBounds.W <= MaxClusterRadius)
+			{
+				Cluster.Bounds = MergedBounds;
+				TargetCluster = &Cluster;
+				break;
+			}
+		}
+
+		if (TargetCluster == nullptr)
+		{
+			TargetCluster = &Clusters.AddDefaulted_GetRef();
+			TargetCluster->Bounds = Blast;
+		}
+
+		TargetCluster->Explosions.Add(i);
+	}
+}
+
+void UDamageResolverSubsystem::ResolveCluster(const FExplosionCluster& Cluster)
+{
+	INC_DWORD_STAT(STAT_TurretAI_ExplosionQueries);
+
+	// Same query as the engine radial damage, only once for all explosions of the cluster.
+	// The causer of one explosion can still be hit by the others, so each explosion ignores its own causer below.
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ResolveExplosions), false);
+
+	TArray<FOverlapResult> Overlaps;
+	GetWorld()->OverlapMultiByObjectType(Overlaps, Cluster.Bounds.Center, FQuat::Identity,
+		FCollisionObjectQueryParams(FCollisionObjectQueryParams::InitType::AllDynamicObjects), FCollisionShape::MakeSphere(Cluster.Bounds.W), QueryParams);
+
+	// Falloff of each explosion for each actor, the closest component takes the blast like the engine radial damage
+	TMap<AActor*, FExplosionScales> ActorScales;
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		AActor* Victim = Overlap.GetActor();
+		const UPrimitiveComponent* Component = Overlap.GetComponent();
+		if (IsValid(Victim) == false || Victim->CanBeDamaged() == false || Component == nullptr)
+		{
+			continue;
+		}
+
+		FExplosionScales& Scales = ActorScales.FindOrAdd(Victim);
+		if (Scales.IsEmpty())
+		{
+			Scales.Init({ -1.0f, nullptr }, Cluster.Explosions.Num());
+		}
+
+		const FBox ComponentBox = Component->Bounds.GetBox();
+		for (int32 i = 0; i < Cluster.Explosions.Num(); ++i)
+		{
+			const FPendingExplosion& Explosion = Explosions[Cluster.Explosions[i]];
+			const float Distance = FMath::Sqrt(ComponentBox.ComputeSquaredDistanceToPoint(Explosion.Origin));
+			if (Victim == Explosion.DamageCauser.Get() || Distance > Explosion.DamageInfo.OuterRadius)
+			{
+				continue;
+			}
+
+			const float Scale = Explosion.DamageInfo.GetDamageScale(Distance);
+			if (Scale > Scales[i].Key)
+			{
+				Scales[i] = { Scale, Component };
+			}
+		}
+	}
+
+	for (const TPair<AActor*, FExplosionScales>& Pair : ActorScales)
+	{
+		const FExplosionScales& Scales = Pair.Value;
+
+		// Explosions of a cluster are close together, one visibility trace from the strongest one stands for all of them
+		int32 StrongestIndex = 0;
+		for (int32 i = 1; i < Scales.Num(); ++i)
+		{
+			StrongestIndex = Scales[i].Key > Scales[StrongestIndex].Key ? i : StrongestIndex;
+		}
+
+		const FPendingExplosion& StrongestExplosion = Explosions[Cluster.Explosions[StrongestIndex]];
+		if (Scales[StrongestIndex].Key < 0.0f
+			|| IsComponentDamageableFrom(Scales[StrongestIndex].Value, StrongestExplosion.Origin, StrongestExplosion.DamageCauser.Get()) == false)
+		{
+			continue;
+		}
+
+		FVictimDamage& VictimDamage = VictimDamages.FindOrAdd(Pair.Key);
+		for (int32 i = 0; i < Scales.Num(); ++i)
+		{
+			if (Scales[i].Key < 0.0f)
+			{
+				continue;
+			}
+
+			// Same falloff as the engine radial damage, the minimum damage applies up to the outer radius
+			const FPendingExplosion& Explosion = Explosions[Cluster.Explosions[i]];
+			const float Damage = FMath::Lerp(Explosion.DamageInfo.MinimumDamage, Explosion.DamageInfo.BaseDamage, Scales[i].Key);
+			VictimDamage.Damage += Damage;
+
+			if (Damage > VictimDamage.MaxDamage)
+			{
+				VictimDamage.MaxDamage = Damage;
+				VictimDamage.InstigatorController = Explosion.InstigatorController.Get();
+				VictimDamage.DamageCauser = Explosion.DamageCauser.Get();
+			}
+		}
+	}
+}
+
+bool UDamageResolverSubsystem::IsComponentDamageableFrom(const UPrimitiveComponent* Component, const FVector& Origin, const AActor* DamageCauser) const
+{
+	const FCollisionQueryParams LineParams(SCENE_QUERY_STAT(ResolveExplosionVisibility), true, DamageCauser);
+
+	FHitResult HitResult;
+	const bool bHit = GetWorld()->LineTraceSingleByChannel(HitResult, Origin, Component->Bounds.Origin, ECC_Visibility, LineParams);
+
+	return bHit == false || HitResult.Component == Component;
+}
+
+void UDamageResolverSubsystem::ApplyVictimDamages()
+{
+	const FDamageEvent DamageEvent(UDamageType::StaticClass());
+
+	for (const TPair<AActor*, FVictimDamage>& Pair : VictimDamages)
+	{
+		// Earlier victims may destroy other victims
+		if (IsValid(Pair.Key))
+		{
+			Pair.Key->TakeDamage(Pair.Value.Damage, DamageEvent, Pair.Value.InstigatorController, Pair.Value.DamageCauser);
+		}
+	}
+}
@@ -0,0 +1,152 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/ProjectilePoolSubsystem.h"
+
+#include "Actors/Projectile.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "TurretAI.h"
+
+static FAutoConsoleCommandWithWorld ProjectilePoolStatsCommand(
+	TEXT("TurretAI.ProjectilePool.Stats"),
+	TEXT("Writes the projectile pool hits and misses of each projectile class to the log"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](const UWorld* World)
+	{
+		if (const UProjectilePoolSubsystem* ProjectilePool = World ? World->GetSubsystem<UProjectilePoolSubsystem>() : nullptr)
+		{
+			ProjectilePool->LogStats();
+		}
+	}));
+
+void UProjectilePoolSubsystem::Deinitialize()
+{
+	// Pooled projectiles are destroyed with the world
+	Pools.Empty();
+	NumActiveProjectiles = 0;
+
+	Super::Deinitialize();
+}
+
+bool UProjectilePoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UProjectilePoolSubsystem::Prewarm(TSubclassOf<AProjectile> ProjectileClass)
+{
+	if (ProjectileClass == nullptr)
+	{
+		return;
+	}
+
+	FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass.Get());
+	if (Pool.bPrewarmed)
+	{
+		return;
+	}
+
+	Pool.bPrewarmed = true;
+	Pool.InactiveProjectiles.Reserve(PrewarmCount);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (int32 i = 0; i < PrewarmCount; ++i)
+	{
+		if (AProjectile* NewProjectile = GetWorld()->SpawnActor<AProjectile>(ProjectileClass, FTransform::Identity, SpawnParams))
+		{
+			NewProjectile->DeactivateToPool();
+			Pool.InactiveProjectiles.Add(NewProjectile);
+		}
+	}
+}
+
+AProjectile* UProjectilePoolSubsystem::AcquireProjectile(TSubclassOf<AProjectile> ProjectileClass, const FTransform& Transform, AActor* Owner, APawn* Instigator)
+{
+	if (ProjectileClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass.Get());
+
+	while (Pool.InactiveProjectiles.IsEmpty() == false)
+	{
+		AProjectile* Projectile = Pool.InactiveProjectiles.Pop(false);
+		if (IsValid(Projectile))
+		{
+			++Pool.NumHits;
+
+			Projectile->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+			Projectile->SetOwner(Owner);
+			Projectile->SetInstigator(Instigator);
+			Projectile->bActiveInPool = true;
+			++NumActiveProjectiles;
+			return Projectile;
+		}
+	}
+
+	++Pool.NumMisses;
+
+	// Only the projectiles that were spawned are counted, the spawn can fail
+	AProjectile* NewProjectile = GetWorld()->SpawnActorDeferred<AProjectile>(ProjectileClass, Transform, Owner, Instigator);
+	if (NewProjectile)
+	{
+		NewProjectile->bActiveInPool = true;
+		++NumActiveProjectiles;
+	}
+
+	return NewProjectile;
+}
+
+void UProjectilePoolSubsystem::LaunchProjectile(AProjectile* Projectile, const FTransform& Transform)
+{
+	if (Projectile->HasActorBegunPlay())
+	{
+		Projectile->ActivateFromPool();
+	}
+	else
+	{
+		UGameplayStatics::FinishSpawningActor(Projectile, Transform);
+	}
+}
+
+bool UProjectilePoolSubsystem::ReleaseProjectile(AProjectile* Projectile)
+{
+	RemoveActiveProjectile(Projectile);
+
+	FProjectilePool& Pool = Pools.FindOrAdd(Projectile->GetClass());
+	if (Pool.InactiveProjectiles.Num() >= MaxPoolSize)
+	{
+		++Pool.NumOverflows;
+		return false;
+	}
+
+	Projectile->DeactivateToPool();
+	Pool.InactiveProjectiles.Add(Projectile);
+	return true;
+}
+
+void UProjectilePoolSubsystem::RemoveActiveProjectile(AProjectile* Projectile)
+{
+	if (Projectile->bActiveInPool)
+	{
+		Projectile->bActiveInPool = false;
+		--NumActiveProjectiles;
+	}
+}
+
+void UProjectilePoolSubsystem::LogStats() const
+{
+	for (const TPair<TObjectPtr<UClass>, FProjectilePool>& Pair : Pools)
+	{
+		const FProjectilePool& Pool = Pair.Value;
+		const int32 NumRequests = Pool.NumHits + Pool.NumMisses;
+
+		UE_LOG(LogTurretAI, Log, TEXT("%s: Inactive %d, Hits %d, Misses %d, Hit Ratio %.1f%%, Overflows %d"),
+			*GetNameSafe(Pair.Key), Pool.InactiveProjectiles.Num(), Pool.NumHits, Pool.NumMisses,
+			NumRequests > 0 ? 100.0f * Pool.NumHits / NumRequests : 0.0f, Pool.NumOverflows);
+	}
+}
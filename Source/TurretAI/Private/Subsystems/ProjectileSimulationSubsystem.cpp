@@ -0,0 +1,309 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/ProjectileSimulationSubsystem.h"
+
+#include "Actors/Projectile.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Sound/SoundBase.h"
+#include "Subsystems/TurretAssetSubsystem.h"
+#include "Subsystems/TurretFXSubsystem.h"
+#include "TurretAIProfiling.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Simulation Tick"), STAT_TurretAI_SimulationTick, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Simulated Projectile Hit"), STAT_TurretAI_SimulatedProjectileHit, STATGROUP_TurretAI);
+
+void FSimulatedProjectileGroup::RemoveAtSwap(int32 Index)
+{
+	Locations.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	RemainingLifeSpans.RemoveAtSwap(Index, 1, false);
+	Explosive.RemoveAtSwap(Index, 1, false);
+	HomingTargets.RemoveAtSwap(Index, 1, false);
+	Owners.RemoveAtSwap(Index, 1, false);
+	Instigators.RemoveAtSwap(Index, 1, false);
+	TraceHandles.RemoveAtSwap(Index, 1, false);
+}
+
+void UProjectileSimulationSubsystem::Deinitialize()
+{
+	Groups.Empty();
+	VisualsActor = nullptr;
+
+	Super::Deinitialize();
+}
+
+bool UProjectileSimulationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UProjectileSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSimulationSubsystem, STATGROUP_Tickables);
+}
+
+int32 UProjectileSimulationSubsystem::GetNumProjectiles() const
+{
+	int32 NumProjectiles = 0;
+	for (const TPair<TObjectPtr<UClass>, FSimulatedProjectileGroup>& Pair : Groups)
+	{
+		NumProjectiles += Pair.Value.Num();
+	}
+
+	return NumProjectiles;
+}
+
+FSimulatedProjectileGroup& UProjectileSimulationSubsystem::FindOrAddGroup(TSubclassOf<AProjectile> ProjectileClass)
+{
+	if (FSimulatedProjectileGroup* ExistingGroup = Groups.Find(ProjectileClass.Get()))
+	{
+		return *ExistingGroup;
+	}
+
+	const AProjectile* Defaults = ProjectileClass->GetDefaultObject<AProjectile>();
+	const UStaticMeshComponent* DefaultMesh = Defaults->GetProjectileMesh();
+	const UProjectileMovementComponent* DefaultMovement = Defaults->GetProjectileMovement();
+	UWorld* World = GetWorld();
+
+	FSimulatedProjectileGroup& Group = Groups.Add(ProjectileClass.Get());
+	Group.DamageInfo = Defaults->GetDamageInfo();
+	Group.CollisionProfile = DefaultMesh->GetCollisionProfileName();
+	Group.MeshScale = DefaultMesh->GetRelativeScale3D();
+	Group.CollisionRadius = DefaultMesh->GetStaticMesh() ? DefaultMesh->GetStaticMesh()->GetBounds().SphereRadius * Group.MeshScale.GetMax() : 1.0f;
+	Group.GravityZ = World->GetGravityZ() * DefaultMovement->ProjectileGravityScale;
+	Group.HomingAcceleration = DefaultMovement->HomingAccelerationMagnitude;
+	Group.MaxSpeed = DefaultMovement->MaxSpeed;
+	Group.LifeSpan = Defaults->InitialLifeSpan;
+
+	// Same as the initialization of the projectile movement component
+	Group.InitialVelocity = DefaultMovement->Velocity;
+	if (DefaultMovement->InitialSpeed > 0.0f)
+	{
+		Group.InitialVelocity = Group.InitialVelocity.GetSafeNormal() * DefaultMovement->InitialSpeed;
+	}
+	Group.bInitialVelocityInLocalSpace = DefaultMovement->bInitialVelocityInLocalSpace;
+
+	// Visuals are not needed on dedicated servers
+	if (World->GetNetMode() == NM_DedicatedServer)
+	{
+		return Group;
+	}
+
+	if (DefaultMesh->GetStaticMesh())
+	{
+		if (VisualsActor == nullptr)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.ObjectFlags |= RF_Transient;
+			VisualsActor = World->SpawnActor<AActor>(SpawnParams);
+		}
+
+		UInstancedStaticMeshComponent* Instances = NewObject<UInstancedStaticMeshComponent>(VisualsActor);
+		Instances->SetStaticMesh(DefaultMesh->GetStaticMesh());
+		for (int32 i = 0; i < DefaultMesh->GetNumMaterials(); ++i)
+		{
+			Instances->SetMaterial(i, DefaultMesh->GetMaterial(i));
+		}
+		Instances->SetMobility(EComponentMobility::Movable);
+		Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Instances->SetGenerateOverlapEvents(false);
+		Instances->SetCanEverAffectNavigation(false);
+		Instances->RegisterComponent();
+		VisualsActor->AddInstanceComponent(Instances);
+
+		Group.Instances = Instances;
+	}
+
+	TArray<FSoftObjectPath> Paths;
+
+	for (const FSoftObjectPath& Path : { Defaults->GetHitParticle().ToSoftObjectPath(), Defaults->GetHitSound().ToSoftObjectPath() })
+	{
+		if (Path.IsValid())
+		{
+			Paths.Add(Path);
+		}
+	}
+
+	// Shared with the projectile actors of the same class
+	const FStreamableDelegate ResolveAssets = FStreamableDelegate::CreateWeakLambda(this, [this, Defaults, ProjectileClass]
+	{
+		if (FSimulatedProjectileGroup* LoadedGroup = Groups.Find(ProjectileClass.Get()))
+		{
+			LoadedGroup->HitParticle = Defaults->GetHitParticle().Get();
+			LoadedGroup->HitSound = Defaults->GetHitSound().Get();
+		}
+	});
+
+	const UGameInstance* GameInstance = World->GetGameInstance();
+	UTurretAssetSubsystem* AssetSubsystem = GameInstance ? GameInstance->GetSubsystem<UTurretAssetSubsystem>() : nullptr;
+	if (AssetSubsystem == nullptr || AssetSubsystem->RequestClassAssets(ProjectileClass, Paths, ResolveAssets))
+	{
+		ResolveAssets.ExecuteIfBound();
+	}
+
+	return Group;
+}
+
+void UProjectileSimulationSubsystem::FireProjectile(TSubclassOf<AProjectile> ProjectileClass, const FTransform& Transform, AActor* Owner, APawn* Instigator, USceneComponent* HomingTarget, bool bExplosive)
+{
+	if (ProjectileClass == nullptr)
+	{
+		return;
+	}
+
+	FSimulatedProjectileGroup& Group = FindOrAddGroup(ProjectileClass);
+
+	Group.Locations.Add(Transform.GetLocation());
+	Group.Velocities.Add(Group.bInitialVelocityInLocalSpace ? Transform.TransformVectorNoScale(Group.InitialVelocity) : Group.InitialVelocity);
+	Group.RemainingLifeSpans.Add(Group.LifeSpan > 0.0f ? Group.LifeSpan : UE_BIG_NUMBER);
+	Group.Explosive.Add(bExplosive ? 1 : 0);
+	Group.HomingTargets.Add(HomingTarget);
+	Group.Owners.Add(Owner);
+	Group.Instigators.Add(Instigator);
+	Group.TraceHandles.Add(FTraceHandle());
+}
+
+void UProjectileSimulationSubsystem::Tick(float DeltaTime)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_SimulationTick);
+	TURRETAI_PROFILE_SCOPE(Tick);
+
+	Super::Tick(DeltaTime);
+
+	for (TPair<TObjectPtr<UClass>, FSimulatedProjectileGroup>& Pair : Groups)
+	{
+		FSimulatedProjectileGroup& Group = Pair.Value;
+
+		ResolveHits(Group);
+		MoveProjectiles(Group, DeltaTime);
+		UpdateInstances(Group);
+	}
+}
+
+void UProjectileSimulationSubsystem::ResolveHits(FSimulatedProjectileGroup& Group) const
+{
+	const UWorld* World = GetWorld();
+
+	for (int32 i = Group.Num() - 1; i >= 0; --i)
+	{
+		FTraceDatum TraceDatum;
+		if (Group.TraceHandles[i].IsValid() && World->QueryTraceData(Group.TraceHandles[i], TraceDatum))
+		{
+			if (const FHitResult* HitResult = FHitResult::GetFirstBlockingHit(TraceDatum.OutHits))
+			{
+				ProjectileHit(Group, i, *HitResult);
+				Group.RemoveAtSwap(i);
+				continue;
+			}
+		}
+
+		if (Group.RemainingLifeSpans[i] <= 0.0f)
+		{
+			Group.RemoveAtSwap(i);
+		}
+	}
+}
+
+void UProjectileSimulationSubsystem::MoveProjectiles(FSimulatedProjectileGroup& Group, float DeltaTime) const
+{
+	UWorld* World = GetWorld();
+
+	FCollisionQueryParams CollisionParams(SCENE_QUERY_STAT(SimulatedProjectile), false);
+	const FCollisionShape CollisionShape = FCollisionShape::MakeSphere(Group.CollisionRadius);
+
+	FTurretStats::AddTraces(Group.Num());
+
+	for (int32 i = 0; i < Group.Num(); ++i)
+	{
+		FVector& Location = Group.Locations[i];
+		FVector& Velocity = Group.Velocities[i];
+
+		// Homing projectiles ignore the gravity, same as the projectile actor
+		FVector Acceleration(0.0f, 0.0f, Group.GravityZ);
+		if (const USceneComponent* HomingTarget = Group.HomingTargets[i].Get())
+		{
+			Acceleration = (HomingTarget->GetComponentLocation() - Location).GetSafeNormal() * Group.HomingAcceleration;
+		}
+
+		Velocity += Acceleration * DeltaTime;
+		if (Group.MaxSpeed > 0.0f)
+		{
+			Velocity = Velocity.GetClampedToMaxSize(Group.MaxSpeed);
+		}
+
+		const FVector NewLocation = Location + Velocity * DeltaTime;
+
+		CollisionParams.ClearIgnoredActors();
+		if (const AActor* Owner = Group.Owners[i].Get())
+		{
+			CollisionParams.AddIgnoredActor(Owner);
+		}
+
+		Group.TraceHandles[i] = World->AsyncSweepByProfile(EAsyncTraceType::Single, Location, NewLocation, FQuat::Identity, Group.CollisionProfile, CollisionShape, CollisionParams);
+
+		Location = NewLocation;
+		Group.RemainingLifeSpans[i] -= DeltaTime;
+	}
+}
+
+void UProjectileSimulationSubsystem::ProjectileHit(const FSimulatedProjectileGroup& Group, int32 Index, const FHitResult& HitResult) const
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_SimulatedProjectileHit);
+
+	UWorld* World = GetWorld();
+	const ENetMode NetMode = World->GetNetMode();
+
+	// Is server?
+	if (NetMode != NM_Client)
+	{
+		const APawn* Instigator = Group.Instigators[Index].Get();
+		AController* InstigatorController = Instigator ? Instigator->GetController() : nullptr;
+		AActor* Owner = Group.Owners[Index].Get();
+
+		if (Group.Explosive[Index])
+		{
+			AProjectile::ApplyExplosiveHit(World, Group.DamageInfo, HitResult, InstigatorController, Owner);
+		}
+		else
+		{
+			AProjectile::ApplyNormalHit(Group.DamageInfo, HitResult, InstigatorController, Owner);
+		}
+	}
+
+	if (UTurretFXSubsystem* FXSubsystem = World->GetSubsystem<UTurretFXSubsystem>())
+	{
+		FXSubsystem->RequestFX(Group.HitParticle, Group.HitSound, HitResult.Location);
+	}
+}
+
+void UProjectileSimulationSubsystem::UpdateInstances(const FSimulatedProjectileGroup& Group)
+{
+	if (Group.Instances == nullptr)
+	{
+		return;
+	}
+
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(Group.Num());
+
+	for (int32 i = 0; i < Group.Num(); ++i)
+	{
+		Transforms.Emplace(Group.Velocities[i].Rotation(), Group.Locations[i], Group.MeshScale);
+	}
+
+	if (Transforms.Num() == Group.Instances->GetInstanceCount())
+	{
+		Group.Instances->BatchUpdateInstancesTransforms(0, Transforms, true, true, true);
+	}
+	else
+	{
+		Group.Instances->ClearInstances();
+		Group.Instances->AddInstances(Transforms, false, true);
+	}
+}
@@ -0,0 +1,68 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/TurretAssetSubsystem.h"
+
+#include "Engine/AssetManager.h"
+
+void UTurretAssetSubsystem::Deinitialize()
+{
+	for (TPair<TObjectKey<UClass>, FClassAssets>& Pair : ClassAssets)
+	{
+		if (Pair.Value.Handle.IsValid())
+		{
+			Pair.Value.Handle->ReleaseHandle();
+		}
+	}
+
+	ClassAssets.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTurretAssetSubsystem::RequestClassAssets(const UClass* Class, const TArray<FSoftObjectPath>& Paths, FStreamableDelegate OnLoaded)
+{
+	if (Paths.IsEmpty())
+	{
+		return true;
+	}
+
+	const TObjectKey<UClass> ClassKey(Class);
+
+	if (FClassAssets* Assets = ClassAssets.Find(ClassKey))
+	{
+		if (Assets->Handle.IsValid() == false || Assets->Handle->HasLoadCompleted())
+		{
+			return true;
+		}
+
+		Assets->PendingDelegates.Add(MoveTemp(OnLoaded));
+		return false;
+	}
+
+	FClassAssets& Assets = ClassAssets.Add(ClassKey);
+	Assets.Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths,
+		FStreamableDelegate::CreateUObject(this, &UTurretAssetSubsystem::ClassAssetsLoaded, ClassKey));
+
+	if (Assets.Handle.IsValid() == false || Assets.Handle->HasLoadCompleted())
+	{
+		return true;
+	}
+
+	Assets.PendingDelegates.Add(MoveTemp(OnLoaded));
+	return false;
+}
+
+void UTurretAssetSubsystem::ClassAssetsLoaded(TObjectKey<UClass> ClassKey)
+{
+	FClassAssets* Assets = ClassAssets.Find(ClassKey);
+	if (Assets == nullptr)
+	{
+		return;
+	}
+
+	TArray<FStreamableDelegate> PendingDelegates = MoveTemp(Assets->PendingDelegates);
+	for (FStreamableDelegate& Delegate : PendingDelegates)
+	{
+		Delegate.ExecuteIfBound();
+	}
+}
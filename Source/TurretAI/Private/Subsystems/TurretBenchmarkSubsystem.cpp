@@ -0,0 +1,428 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/TurretBenchmarkSubsystem.h"
+
+#include "Actors/Turret.h"
+#include "Actors/TurretBenchmarkTarget.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Subsystems/ProjectilePoolSubsystem.h"
+#include "Subsystems/ProjectileSimulationSubsystem.h"
+#include "Subsystems/TurretManagerSubsystem.h"
+#include "Subsystems/TurretProxySubsystem.h"
+#include "TurretAI.h"
+#include "TurretAIProfiling.h"
+#include "UObject/UObjectGlobals.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CombatBenchmarkCommand(
+	TEXT("TurretAI.Benchmark.Combat"),
+	TEXT("Runs the turret combat benchmark and writes the results to the profiling directory. Usage: TurretAI.Benchmark.Combat [NumTurrets] [NumTargets] [Duration] [Name] [bProxies]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTurretBenchmarkSubsystem* Benchmark = World ? World->GetSubsystem<UTurretBenchmarkSubsystem>() : nullptr)
+		{
+			Benchmark->StartBenchmark(
+				Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 256,
+				Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 64,
+				Args.Num() > 2 ? FCString::Atof(*Args[2]) : 30.0f,
+				Args.Num() > 3 ? Args[3] : TEXT("TurretCombat"),
+				Args.Num() > 4 && FCString::ToBool(*Args[4]));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs SkipConvergedBenchmarkCommand(
+	TEXT("TurretAI.Benchmark.SkipConverged"),
+	TEXT("Runs the turret combat benchmark with the converged rotation skip on and then off, and writes the game thread time of both runs to the log. Usage: TurretAI.Benchmark.SkipConverged [NumTurrets] [NumTargets] [Duration]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTurretBenchmarkSubsystem* Benchmark = World ? World->GetSubsystem<UTurretBenchmarkSubsystem>() : nullptr)
+		{
+			Benchmark->StartSkipConvergedBenchmark(
+				Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 256,
+				Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 64,
+				Args.Num() > 2 ? FCString::Atof(*Args[2]) : 30.0f);
+		}
+	}));
+
+void UTurretBenchmarkSubsystem::Deinitialize()
+{
+	if (bRunning)
+	{
+		FTurretProfiler::bEnabled = false;
+		FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+		FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+		bRunning = false;
+	}
+
+	SpawnedActors.Empty();
+	Frames.Empty();
+	PendingSkipConverged.Empty();
+	SkipConvergedResults.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTurretBenchmarkSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UTurretBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTurretBenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+void UTurretBenchmarkSubsystem::StartBenchmark(int32 NumTurrets, int32 NumTargets, float Duration, const FString& Name, bool bProxies)
+{
+	if (bRunning)
+	{
+		UE_LOG(LogTurretAI, Warning, TEXT("Turret benchmark is already running"));
+		return;
+	}
+
+	if (TurretClasses.IsEmpty())
+	{
+		TurretClasses.Add(FSoftClassPath(TEXT("/TurretAI/Blueprints/BP_Turret.BP_Turret_C")));
+		TurretClasses.Add(FSoftClassPath(TEXT("/TurretAI/Blueprints/BP_Turret_Shotgun.BP_Turret_Shotgun_C")));
+	}
+
+	BenchmarkName = Name;
+	BenchmarkTurrets = FMath::Max(NumTurrets, 0);
+	BenchmarkTargets = FMath::Max(NumTargets, 0);
+	bBenchmarkProxies = bProxies;
+	BenchmarkDuration = FMath::Max(Duration, 0.0f);
+	WarmupRemaining = WarmupTime;
+	TimeRemaining = BenchmarkDuration;
+	Frames.Reset();
+
+	SpawnTurrets(BenchmarkTurrets);
+	SpawnTargets(BenchmarkTargets);
+
+	PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UTurretBenchmarkSubsystem::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UTurretBenchmarkSubsystem::OnPostGarbageCollect);
+
+	bRunning = true;
+
+	UE_LOG(LogTurretAI, Display, TEXT("Turret benchmark %s started: %d %s, %d targets, %.1f seconds"), *BenchmarkName, BenchmarkTurrets,
+		bBenchmarkProxies ? TEXT("proxy turrets") : TEXT("turrets"), BenchmarkTargets, TimeRemaining);
+}
+
+void UTurretBenchmarkSubsystem::StartSkipConvergedBenchmark(int32 NumTurrets, int32 NumTargets, float Duration)
+{
+	if (bRunning)
+	{
+		UE_LOG(LogTurretAI, Warning, TEXT("Turret benchmark is already running"));
+		return;
+	}
+
+	const UTurretManagerSubsystem* TurretManager = GetWorld()->GetSubsystem<UTurretManagerSubsystem>();
+	if (TurretManager == nullptr)
+	{
+		return;
+	}
+
+	bSkipConvergedBefore = TurretManager->GetSkipConvergedRotations();
+	BenchmarkTurrets = FMath::Max(NumTurrets, 0);
+	BenchmarkTargets = FMath::Max(NumTargets, 0);
+	BenchmarkDuration = FMath::Max(Duration, 0.0f);
+
+	PendingSkipConverged = { true, false };
+	SkipConvergedResults.Reset();
+
+	StartNextSkipConvergedRun();
+}
+
+void UTurretBenchmarkSubsystem::StartNextSkipConvergedRun()
+{
+	UTurretManagerSubsystem* TurretManager = GetWorld()->GetSubsystem<UTurretManagerSubsystem>();
+	if (TurretManager == nullptr)
+	{
+		PendingSkipConverged.Reset();
+		return;
+	}
+
+	if (PendingSkipConverged.Num() > 0)
+	{
+		const bool bSkip = PendingSkipConverged[0];
+		PendingSkipConverged.RemoveAt(0);
+
+		// The runs spawn the same grid and the same target paths, so only the skip differs
+		TurretManager->SetSkipConvergedRotations(bSkip);
+		StartBenchmark(BenchmarkTurrets, BenchmarkTargets, BenchmarkDuration, bSkip ? TEXT("SkipConvergedOn") : TEXT("SkipConvergedOff"));
+		return;
+	}
+
+	TurretManager->SetSkipConvergedRotations(bSkipConvergedBefore);
+
+	for (const TPair<bool, float>& Result : SkipConvergedResults)
+	{
+		UE_LOG(LogTurretAI, Display, TEXT("Converged rotation skip %s: %.3f ms average game thread time"), Result.Key ? TEXT("on") : TEXT("off"), Result.Value);
+	}
+
+	if (SkipConvergedResults.Num() == 2)
+	{
+		UE_LOG(LogTurretAI, Display, TEXT("Converged rotation skip saves %.3f ms of game thread time per frame with %d turrets"),
+			SkipConvergedResults[1].Value - SkipConvergedResults[0].Value, BenchmarkTurrets);
+	}
+
+	SkipConvergedResults.Reset();
+}
+
+void UTurretBenchmarkSubsystem::SpawnTurrets(int32 NumTurrets)
+{
+	TArray<UClass*> Classes;
+	for (const FSoftClassPath& ClassPath : TurretClasses)
+	{
+		UClass* TurretClass = ClassPath.TryLoadClass<ATurret>();
+		if (TurretClass && TurretClass->HasAnyClassFlags(CLASS_Abstract) == false)
+		{
+			Classes.Add(TurretClass);
+		}
+		else
+		{
+			UE_LOG(LogTurretAI, Warning, TEXT("Turret benchmark can't use turret class %s"), *ClassPath.ToString());
+		}
+	}
+
+	if (Classes.IsEmpty())
+	{
+		return;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	UTurretProxySubsystem* ProxySubsystem = bBenchmarkProxies ? GetWorld()->GetSubsystem<UTurretProxySubsystem>() : nullptr;
+
+	// Square grid around the world origin
+	const int32 GridSize = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(NumTurrets)));
+	const float HalfExtent = 0.5f * (GridSize - 1) * TurretSpacing;
+
+	for (int32 i = 0; i < NumTurrets; ++i)
+	{
+		const FVector Location(i % GridSize * TurretSpacing - HalfExtent, i / GridSize * TurretSpacing - HalfExtent, 0.0f);
+		if (ProxySubsystem)
+		{
+			ProxySubsystem->AddProxy(Classes[i % Classes.Num()], FTransform(Location));
+		}
+		else
+		{
+			SpawnedActors.Add(GetWorld()->SpawnActor<ATurret>(Classes[i % Classes.Num()], Location, FRotator::ZeroRotator, SpawnParams));
+		}
+	}
+}
+
+void UTurretBenchmarkSubsystem::SpawnTargets(int32 NumTargets)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// Same paths on every run so the results are comparable between versions
+	FRandomStream RandomStream(1234);
+
+	const int32 GridSize = FMath::Max(1, FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(BenchmarkTurrets))));
+	const float HalfExtent = 0.5f * GridSize * TurretSpacing;
+
+	for (int32 i = 0; i < NumTargets; ++i)
+	{
+		const FVector Center(RandomStream.FRandRange(-HalfExtent, HalfExtent), RandomStream.FRandRange(-HalfExtent, HalfExtent), 100.0f);
+		const float Radius = RandomStream.FRandRange(0.5f, 2.0f) * TurretSpacing;
+		const float Speed = RandomStream.RandBool() ? TargetSpeed : -TargetSpeed;
+
+		if (ATurretBenchmarkTarget* Target = GetWorld()->SpawnActor<ATurretBenchmarkTarget>(Center, FRotator::ZeroRotator, SpawnParams))
+		{
+			Target->InitializePath(Center, Radius, Speed, RandomStream.FRandRange(-UE_PI, UE_PI));
+			SpawnedActors.Add(Target);
+		}
+	}
+}
+
+void UTurretBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (bRunning == false)
+	{
+		return;
+	}
+
+	if (WarmupRemaining > 0.0f)
+	{
+		WarmupRemaining -= DeltaTime;
+		if (WarmupRemaining <= 0.0f)
+		{
+			// The measured frames start from here
+			FTurretProfiler::Reset();
+			FTurretProfiler::bEnabled = true;
+			GCTime = 0.0;
+		}
+
+		return;
+	}
+
+	RecordFrame(DeltaTime);
+
+	TimeRemaining -= DeltaTime;
+	if (TimeRemaining <= 0.0f)
+	{
+		FinishBenchmark();
+	}
+}
+
+void UTurretBenchmarkSubsystem::RecordFrame(float DeltaTime)
+{
+	const auto ToMilliseconds = [](uint64 Cycles) { return static_cast<float>(FPlatformTime::ToMilliseconds64(Cycles)); };
+
+	// Everything since the last tick of the benchmark, which is one full frame
+	FTurretBenchmarkFrame& Frame = Frames.AddDefaulted_GetRef();
+	Frame.FrameTime = DeltaTime * 1000.0f;
+	Frame.GameThreadTime = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Frame.TickTime = ToMilliseconds(FTurretProfiler::Cycles[static_cast<int32>(ETurretProfileCategory::Tick)]);
+	Frame.TargetingTime = ToMilliseconds(FTurretProfiler::Cycles[static_cast<int32>(ETurretProfileCategory::Targeting)]);
+	Frame.TraceTime = ToMilliseconds(FTurretProfiler::Cycles[static_cast<int32>(ETurretProfileCategory::Traces)]);
+	Frame.SpawnTime = ToMilliseconds(FTurretProfiler::Cycles[static_cast<int32>(ETurretProfileCategory::Spawn)]);
+	Frame.DamageTime = ToMilliseconds(FTurretProfiler::Cycles[static_cast<int32>(ETurretProfileCategory::Damage)]);
+	Frame.GCTime = static_cast<float>(GCTime * 1000.0);
+	Frame.UsedMemory = static_cast<float>(FPlatformMemory::GetStats().UsedPhysical) / (1024.0f * 1024.0f);
+
+	if (const UProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+	{
+		Frame.NumProjectiles += ProjectilePool->GetNumActiveProjectiles();
+	}
+
+	if (const UProjectileSimulationSubsystem* ProjectileSimulation = GetWorld()->GetSubsystem<UProjectileSimulationSubsystem>())
+	{
+		Frame.NumProjectiles += ProjectileSimulation->GetNumProjectiles();
+	}
+
+	FTurretProfiler::Reset();
+	GCTime = 0.0;
+}
+
+void UTurretBenchmarkSubsystem::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void UTurretBenchmarkSubsystem::OnPostGarbageCollect()
+{
+	GCTime += FPlatformTime::Seconds() - GCStartTime;
+}
+
+void UTurretBenchmarkSubsystem::FinishBenchmark()
+{
+	bRunning = false;
+	FTurretProfiler::bEnabled = false;
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+
+	WriteResults();
+
+	for (const TWeakObjectPtr<AActor>& Actor : SpawnedActors)
+	{
+		if (Actor.IsValid())
+		{
+			Actor->Destroy();
+		}
+	}
+
+	SpawnedActors.Reset();
+
+	if (UTurretProxySubsystem* ProxySubsystem = bBenchmarkProxies ? GetWorld()->GetSubsystem<UTurretProxySubsystem>() : nullptr)
+	{
+		ProxySubsystem->RemoveAllProxies();
+	}
+
+	// The comparison exits after its last run
+	if (PendingSkipConverged.Num() > 0 || SkipConvergedResults.Num() > 0)
+	{
+		const UTurretManagerSubsystem* TurretManager = GetWorld()->GetSubsystem<UTurretManagerSubsystem>();
+		SkipConvergedResults.Emplace(TurretManager && TurretManager->GetSkipConvergedRotations(), GetAverageGameThreadTime());
+		StartNextSkipConvergedRun();
+
+		if (bRunning)
+		{
+			return;
+		}
+	}
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("TurretBenchmarkExit")))
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+float UTurretBenchmarkSubsystem::GetAverageGameThreadTime() const
+{
+	float Sum = 0.0f;
+	for (const FTurretBenchmarkFrame& Frame : Frames)
+	{
+		Sum += Frame.GameThreadTime;
+	}
+
+	return Frames.IsEmpty() ? 0.0f : Sum / Frames.Num();
+}
+
+void UTurretBenchmarkSubsystem::WriteResults() const
+{
+	if (Frames.IsEmpty())
+	{
+		UE_LOG(LogTurretAI, Warning, TEXT("Turret benchmark %s has no frames"), *BenchmarkName);
+		return;
+	}
+
+	const FString Directory = FPaths::Combine(FPaths::ProfilingDir(), TEXT("TurretAI"));
+	const FString BaseName = FPaths::Combine(Directory, FString::Printf(TEXT("%s_%s"), *BenchmarkName, *FDateTime::Now().ToString()));
+	IFileManager::Get().MakeDirectory(*Directory, true);
+
+	FString Csv = TEXT("Frame,FrameMs,GameThreadMs,TickMs,TargetingMs,TracesMs,SpawnMs,DamageMs,GCMs,Projectiles,UsedMemoryMB\n");
+	FTurretBenchmarkFrame Sum;
+	float PeakMemory = 0.0f;
+	TArray<float> GameThreadTimes;
+	GameThreadTimes.Reserve(Frames.Num());
+
+	for (int32 i = 0; i < Frames.Num(); ++i)
+	{
+		const FTurretBenchmarkFrame& Frame = Frames[i];
+		Csv += FString::Printf(TEXT("%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%.1f\n"), i, Frame.FrameTime, Frame.GameThreadTime, Frame.TickTime, Frame.TargetingTime,
+			Frame.TraceTime, Frame.SpawnTime, Frame.DamageTime, Frame.GCTime, Frame.NumProjectiles, Frame.UsedMemory);
+
+		Sum.FrameTime += Frame.FrameTime;
+		Sum.GameThreadTime += Frame.GameThreadTime;
+		Sum.TickTime += Frame.TickTime;
+		Sum.TargetingTime += Frame.TargetingTime;
+		Sum.TraceTime += Frame.TraceTime;
+		Sum.SpawnTime += Frame.SpawnTime;
+		Sum.DamageTime += Frame.DamageTime;
+		Sum.GCTime += Frame.GCTime;
+		Sum.NumProjectiles = FMath::Max(Sum.NumProjectiles, Frame.NumProjectiles);
+		PeakMemory = FMath::Max(PeakMemory, Frame.UsedMemory);
+		GameThreadTimes.Add(Frame.GameThreadTime);
+	}
+
+	GameThreadTimes.Sort();
+	const float Num = static_cast<float>(Frames.Num());
+	const float Median = GameThreadTimes[GameThreadTimes.Num() / 2];
+	const float P95 = GameThreadTimes[FMath::Min(FMath::FloorToInt32(0.95f * Num), GameThreadTimes.Num() - 1)];
+
+	FString Json = TEXT("{\n");
+	Json += FString::Printf(TEXT("\t\"Name\": \"%s\",\n"), *BenchmarkName.ReplaceCharWithEscapedChar());
+	Json += FString::Printf(TEXT("\t\"Turrets\": %d,\n\t\"Proxies\": %s,\n\t\"Targets\": %d,\n\t\"Frames\": %d,\n"), BenchmarkTurrets,
+		bBenchmarkProxies ? TEXT("true") : TEXT("false"), BenchmarkTargets, Frames.Num());
+	Json += FString::Printf(TEXT("\t\"AvgFrameMs\": %.3f,\n\t\"AvgGameThreadMs\": %.3f,\n\t\"MedianGameThreadMs\": %.3f,\n\t\"P95GameThreadMs\": %.3f,\n\t\"MaxGameThreadMs\": %.3f,\n"),
+		Sum.FrameTime / Num, Sum.GameThreadTime / Num, Median, P95, GameThreadTimes.Last());
+	Json += FString::Printf(TEXT("\t\"AvgTickMs\": %.3f,\n\t\"AvgTargetingMs\": %.3f,\n\t\"AvgTracesMs\": %.3f,\n\t\"AvgSpawnMs\": %.3f,\n\t\"AvgDamageMs\": %.3f,\n"),
+		Sum.TickTime / Num, Sum.TargetingTime / Num, Sum.TraceTime / Num, Sum.SpawnTime / Num, Sum.DamageTime / Num);
+	Json += FString::Printf(TEXT("\t\"TotalGCMs\": %.3f,\n\t\"PeakProjectiles\": %d,\n\t\"PeakUsedMemoryMB\": %.1f\n"), Sum.GCTime, Sum.NumProjectiles, PeakMemory);
+	Json += TEXT("}\n");
+
+	FFileHelper::SaveStringToFile(Csv, *(BaseName + TEXT(".csv")));
+	FFileHelper::SaveStringToFile(Json, *(BaseName + TEXT(".json")));
+
+	UE_LOG(LogTurretAI, Display, TEXT("Turret benchmark %s finished: %d frames, %.3f ms average game thread time, results written to %s"),
+		*BenchmarkName, Frames.Num(), Sum.GameThreadTime / Num, *BaseName);
+}
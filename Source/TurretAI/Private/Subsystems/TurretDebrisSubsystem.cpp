@@ -0,0 +1,187 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/TurretDebrisSubsystem.h"
+
+#include "Actors/DestroyedStructure.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/World.h"
+#include "TurretAIProfiling.h"
+
+DECLARE_CYCLE_STAT(TEXT("Debris Tick"), STAT_TurretAI_DebrisTick, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Spawn Debris"), STAT_TurretAI_SpawnDebris, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Debris Pieces"), STAT_TurretAI_DebrisPieces, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simulated Debris Pieces"), STAT_TurretAI_SimulatedDebrisPieces, STATGROUP_TurretAI);
+
+bool UTurretDebrisSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Debris is not replicated, each client spawns its own
+	return Super::ShouldCreateSubsystem(Outer) && IsRunningDedicatedServer() == false;
+}
+
+void UTurretDebrisSubsystem::Deinitialize()
+{
+	// Pieces are destroyed with the world
+	ActivePieces.Empty();
+	InactivePieces.Empty();
+	NumSimulatedPieces = 0;
+
+	Super::Deinitialize();
+}
+
+bool UTurretDebrisSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UTurretDebrisSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTurretDebrisSubsystem, STATGROUP_Tickables);
+}
+
+void UTurretDebrisSubsystem::SpawnDebris(const UStaticMeshComponent* Source)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_SpawnDebris);
+	TURRETAI_PROFILE_SCOPE(Spawn);
+
+	// Dedicated servers in the editor still create the subsystem
+	if (Source == nullptr || Source->GetStaticMesh() == nullptr || GetWorld()->GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	const FTransform& Transform = Source->GetComponentTransform();
+	ADestroyedStructure* Piece = AcquirePiece(Transform);
+	if (Piece == nullptr)
+	{
+		return;
+	}
+
+	FTurretDebrisPiece& DebrisPiece = ActivePieces.AddDefaulted_GetRef();
+	DebrisPiece.Piece = Piece;
+	DebrisPiece.ExpireTime = GetWorld()->GetTimeSeconds() + LifeTime;
+	DebrisPiece.bSimulated = NumSimulatedPieces < MaxSimulatedPieces;
+
+	if (DebrisPiece.bSimulated)
+	{
+		++NumSimulatedPieces;
+	}
+	else
+	{
+		// A single trace instead of the physics, the piece stops where the trace hits the ground
+		const FVector Start = Transform.GetLocation();
+		const FVector End = Start - FVector(0.0f, 0.0f, 10000.0f);
+
+		// The destroyed turret is still in the world, its own parts aren't the ground
+		const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(DebrisGround), false, Source->GetOwner());
+
+		FHitResult HitResult;
+		const bool bHit = GetWorld()->LineTraceSingleByObjectType(HitResult, Start, End, FCollisionObjectQueryParams(ECC_WorldStatic), QueryParams);
+		DebrisPiece.GroundZ = bHit ? HitResult.ImpactPoint.Z : Start.Z;
+	}
+
+	Piece->Initialize(Source->GetStaticMesh(), Source->GetMaterials(), Source->GetLinearDamping(), Source->GetAngularDamping(), DebrisPiece.bSimulated);
+}
+
+ADestroyedStructure* UTurretDebrisSubsystem::AcquirePiece(const FTransform& Transform)
+{
+	while (InactivePieces.IsEmpty() == false)
+	{
+		ADestroyedStructure* Piece = InactivePieces.Pop(false);
+		if (IsValid(Piece))
+		{
+			Piece->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+			return Piece;
+		}
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	return GetWorld()->SpawnActor<ADestroyedStructure>(ADestroyedStructure::StaticClass(), Transform, SpawnParams);
+}
+
+void UTurretDebrisSubsystem::ReleasePiece(int32 Index)
+{
+	const FTurretDebrisPiece& DebrisPiece = ActivePieces[Index];
+	ADestroyedStructure* Piece = DebrisPiece.Piece;
+
+	if (DebrisPiece.bSimulated)
+	{
+		--NumSimulatedPieces;
+	}
+
+	ActivePieces.RemoveAtSwap(Index, 1, false);
+
+	if (IsValid(Piece) == false)
+	{
+		return;
+	}
+
+	if (InactivePieces.Num() >= MaxPoolSize)
+	{
+		Piece->Destroy();
+		return;
+	}
+
+	Piece->Deactivate();
+	InactivePieces.Add(Piece);
+}
+
+void UTurretDebrisSubsystem::Tick(float DeltaTime)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_DebrisTick);
+
+	Super::Tick(DeltaTime);
+
+	const float TimeSeconds = GetWorld()->GetTimeSeconds();
+	const float GravityZ = GetWorld()->GetGravityZ();
+
+	for (int32 i = ActivePieces.Num() - 1; i >= 0; --i)
+	{
+		FTurretDebrisPiece& DebrisPiece = ActivePieces[i];
+		if (TimeSeconds >= DebrisPiece.ExpireTime || IsValid(DebrisPiece.Piece) == false)
+		{
+			ReleasePiece(i);
+			continue;
+		}
+
+		if (DebrisPiece.bSinking == false && TimeSeconds >= DebrisPiece.ExpireTime - SinkDuration)
+		{
+			DebrisPiece.bSinking = true;
+			if (DebrisPiece.bSimulated)
+			{
+				DebrisPiece.Piece->StartSink();
+			}
+		}
+
+		if (DebrisPiece.bSimulated == false)
+		{
+			MovePiece(DebrisPiece, DeltaTime, GravityZ, SinkSpeed);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_TurretAI_DebrisPieces, ActivePieces.Num());
+	SET_DWORD_STAT(STAT_TurretAI_SimulatedDebrisPieces, NumSimulatedPieces);
+}
+
+void UTurretDebrisSubsystem::MovePiece(FTurretDebrisPiece& DebrisPiece, float DeltaTime, float GravityZ, float InSinkSpeed)
+{
+	FVector Location = DebrisPiece.Piece->GetActorLocation();
+
+	if (DebrisPiece.bSinking)
+	{
+		Location.Z -= InSinkSpeed * DeltaTime;
+	}
+	else if (Location.Z > DebrisPiece.GroundZ)
+	{
+		DebrisPiece.VelocityZ += GravityZ * DeltaTime;
+		Location.Z = FMath::Max(Location.Z + DebrisPiece.VelocityZ * DeltaTime, DebrisPiece.GroundZ);
+	}
+	else
+	{
+		return;
+	}
+
+	// The piece has no collision, so moving it is only a transform update
+	DebrisPiece.Piece->SetActorLocation(Location);
+}
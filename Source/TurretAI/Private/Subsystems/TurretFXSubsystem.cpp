@@ -0,0 +1,160 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/TurretFXSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "NiagaraFunctionLibrary.h"
+#include "NiagaraSystem.h"
+#include "Sound/SoundBase.h"
+#include "TurretAIProfiling.h"
+
+DECLARE_CYCLE_STAT(TEXT("FX Dispatch"), STAT_TurretAI_FXDispatch, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FX Spawned"), STAT_TurretAI_FXSpawned, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FX Culled"), STAT_TurretAI_FXCulled, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FX Coalesced"), STAT_TurretAI_FXCoalesced, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FX Over Budget"), STAT_TurretAI_FXOverBudget, STATGROUP_TurretAI);
+
+bool UTurretFXSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Nothing is seen or heard on a dedicated server
+	return Super::ShouldCreateSubsystem(Outer) && IsRunningDedicatedServer() == false;
+}
+
+void UTurretFXSubsystem::Deinitialize()
+{
+	Requests.Empty();
+	ViewLocations.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTurretFXSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UTurretFXSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTurretFXSubsystem, STATGROUP_Tickables);
+}
+
+void UTurretFXSubsystem::RequestFX(UNiagaraSystem* System, USoundBase* Sound, const FVector& Location, const FRotator& Rotation, const FVector& Scale, bool bBudgeted)
+{
+	// Dedicated servers in the editor still create the subsystem
+	if ((System == nullptr && Sound == nullptr) || GetWorld()->GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	// The view points are collected by the first request of each frame, requests can come before the tick of the subsystem
+	if (ViewLocationsFrame != GFrameCounter)
+	{
+		UpdateViewLocations();
+	}
+
+	// Without a known view point nothing is culled
+	float ViewDistanceSquared = ViewLocations.IsEmpty() ? 0.0f : UE_BIG_NUMBER;
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		ViewDistanceSquared = FMath::Min(ViewDistanceSquared, static_cast<float>(FVector::DistSquared(ViewLocation, Location)));
+	}
+
+	if (ViewDistanceSquared > FMath::Square(CullDistance))
+	{
+		INC_DWORD_STAT(STAT_TurretAI_FXCulled);
+		return;
+	}
+
+	// A shotgun volley or many hits at one place look the same as one effect
+	const float CoalesceDistanceSquared = FMath::Square(CoalesceDistance);
+	for (FFXRequest& Request : Requests)
+	{
+		if (Request.System == System && Request.Sound == Sound && FVector::DistSquared(Request.Location, Location) <= CoalesceDistanceSquared)
+		{
+			Request.bBudgeted &= bBudgeted;
+			INC_DWORD_STAT(STAT_TurretAI_FXCoalesced);
+			return;
+		}
+	}
+
+	Requests.Add({ System, Sound, Location, Rotation, Scale, ViewDistanceSquared, bBudgeted });
+}
+
+void UTurretFXSubsystem::Tick(float DeltaTime)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_FXDispatch);
+
+	Super::Tick(DeltaTime);
+
+	if (Requests.IsEmpty())
+	{
+		return;
+	}
+
+	// Nearest effects first, they are the ones that are noticed when dropped
+	Requests.Sort([](const FFXRequest& A, const FFXRequest& B) { return A.ViewDistanceSquared < B.ViewDistanceSquared; });
+
+	int32 NumBudgetedSpawns = 0;
+	for (const FFXRequest& Request : Requests)
+	{
+		if (Request.bBudgeted)
+		{
+			if (NumBudgetedSpawns >= MaxSpawnsPerFrame)
+			{
+				INC_DWORD_STAT(STAT_TurretAI_FXOverBudget);
+				continue;
+			}
+
+			++NumBudgetedSpawns;
+		}
+
+		SpawnFX(Request);
+	}
+
+	Requests.Reset();
+}
+
+void UTurretFXSubsystem::UpdateViewLocations()
+{
+	ViewLocations.Reset();
+	ViewLocationsFrame = GFrameCounter;
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+}
+
+void UTurretFXSubsystem::SpawnFX(const FFXRequest& Request) const
+{
+	INC_DWORD_STAT(STAT_TurretAI_FXSpawned);
+
+	if (Request.System)
+	{
+		// Pooled components are returned to the world pool when the effect finishes
+		FFXSystemSpawnParameters SpawnParams;
+		SpawnParams.WorldContextObject = GetWorld();
+		SpawnParams.SystemTemplate = Request.System;
+		SpawnParams.Location = Request.Location;
+		SpawnParams.Rotation = Request.Rotation;
+		SpawnParams.Scale = Request.Scale;
+		SpawnParams.PoolingMethod = EPSCPoolMethod::AutoRelease;
+		SpawnParams.bPreCullCheck = true;
+		UNiagaraFunctionLibrary::SpawnSystemAtLocationWithParams(SpawnParams);
+	}
+
+	if (Request.Sound)
+	{
+		// One shot sounds don't need an audio component
+		UGameplayStatics::PlaySoundAtLocation(GetWorld(), Request.Sound, Request.Location, Request.Rotation);
+	}
+}
@@ -0,0 +1,94 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/TurretFireEventSubsystem.h"
+
+#include "Actors/Turret.h"
+#include "Actors/TurretFireEventStream.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "TurretAIProfiling.h"
+
+void UTurretFireEventSubsystem::Deinitialize()
+{
+	// Streams are destroyed with the world
+	Streams.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTurretFireEventSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTurretFireEventSubsystem::AddFireEvent(ATurret* Turret, uint16 Seed)
+{
+	UWorld* World = GetWorld();
+	if (World->GetNetMode() == NM_Standalone || World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	const AGameStateBase* GameState = World->GetGameState();
+	const float ServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+	const FVector TurretLocation = Turret->GetActorLocation();
+
+	RemoveStaleStreams();
+
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+
+		// Local players have already played the shot
+		if (PlayerController == nullptr || PlayerController->IsLocalController())
+		{
+			continue;
+		}
+
+		// Same distance test as the relevancy of the turret
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		if (FVector::DistSquared(ViewLocation, TurretLocation) > Turret->GetNetCullDistanceSquared())
+		{
+			continue;
+		}
+
+		if (ATurretFireEventStream* Stream = FindOrAddStream(PlayerController))
+		{
+			Stream->AddEvent(Turret, Seed, ServerTime, MaxEventAge, MaxEventsPerStream);
+			FTurretStats::AddFireEvents(1);
+		}
+	}
+}
+
+ATurretFireEventStream* UTurretFireEventSubsystem::FindOrAddStream(APlayerController* PlayerController)
+{
+	TWeakObjectPtr<ATurretFireEventStream>& Stream = Streams.FindOrAdd(PlayerController);
+	if (Stream.IsValid() == false)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = PlayerController;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		Stream = GetWorld()->SpawnActor<ATurretFireEventStream>(SpawnParams);
+	}
+
+	return Stream.Get();
+}
+
+void UTurretFireEventSubsystem::RemoveStaleStreams()
+{
+	for (auto It = Streams.CreateIterator(); It; ++It)
+	{
+		if (It.Key().IsValid() == false)
+		{
+			if (ATurretFireEventStream* Stream = It.Value().Get())
+			{
+				Stream->Destroy();
+			}
+
+			It.RemoveCurrent();
+		}
+	}
+}
@@ -0,0 +1,703 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/TurretManagerSubsystem.h"
+
+#include "Actors/Turret.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Subsystems/ProjectilePoolSubsystem.h"
+#include "Subsystems/ProjectileSimulationSubsystem.h"
+#include "TurretAI.h"
+#include "TurretAIProfiling.h"
+#include "Types/TurretAimSolver.h"
+
+DECLARE_CYCLE_STAT(TEXT("Turret Manager Tick"), STAT_TurretAI_ManagerTick, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Update LODs"), STAT_TurretAI_UpdateLODs, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Update Rotations"), STAT_TurretAI_UpdateRotations, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Apply Rotations"), STAT_TurretAI_ApplyRotations, STATGROUP_TurretAI);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Dormant Turrets"), STAT_TurretAI_DormantTurrets, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Idle Sweep Turrets"), STAT_TurretAI_IdleSweepTurrets, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Acquiring Turrets"), STAT_TurretAI_AcquiringTurrets, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Engaging Turrets"), STAT_TurretAI_EngagingTurrets, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Destroyed Turrets"), STAT_TurretAI_DestroyedTurrets, STATGROUP_TurretAI);
+
+static TAutoConsoleVariable<int32> CVarTurretLODMeasureCost(
+	TEXT("TurretAI.LOD.MeasureCost"),
+	0,
+	TEXT("Measures the rotation update cost of each turret LOD for TurretAI.LOD.Stats, adds two timer reads per updated turret."),
+	ECVF_Default);
+
+/** Bits of the rotation changes of a turret in the last update */
+static constexpr uint8 YawChangedFlag = 1 << 0;
+static constexpr uint8 PitchChangedFlag = 1 << 1;
+
+/** Remaining angle in degrees below which an axis is treated as converged */
+static constexpr float ConvergedAngle = 1.0e-3f;
+
+static FAutoConsoleCommandWithWorld TurretLODStatsCommand(
+	TEXT("TurretAI.LOD.Stats"),
+	TEXT("Writes the number of turrets and the update cost of each turret LOD to the log, the costs are reset after each call. The LOD costs are only measured with TurretAI.LOD.MeasureCost 1"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](const UWorld* World)
+	{
+		if (UTurretManagerSubsystem* TurretManager = World ? World->GetSubsystem<UTurretManagerSubsystem>() : nullptr)
+		{
+			TurretManager->LogLODStats();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs WakeTurretsCommand(
+	TEXT("TurretAI.State.Wake"),
+	TEXT("Wakes up the dormant turrets around the view point of the first player. Usage: TurretAI.State.Wake [Radius]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UTurretManagerSubsystem* TurretManager = World ? World->GetSubsystem<UTurretManagerSubsystem>() : nullptr;
+		const APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		if (TurretManager && PlayerController)
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			TurretManager->WakeTurrets(ViewLocation, Args.Num() > 0 ? FCString::Atof(*Args[0]) : 5000.0f);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs ParallelAimBenchmarkCommand(
+	TEXT("TurretAI.Benchmark.ParallelAim"),
+	TEXT("Measures the aim update of the turrets in the world from one task to one task per worker thread, run it during the combat benchmark. Usage: TurretAI.Benchmark.ParallelAim [NumIterations]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTurretManagerSubsystem* TurretManager = World ? World->GetSubsystem<UTurretManagerSubsystem>() : nullptr)
+		{
+			TurretManager->RunParallelBenchmark(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100);
+		}
+	}));
+
+void UTurretManagerSubsystem::Deinitialize()
+{
+	for (ATurret* Turret : Turrets)
+	{
+		if (Turret)
+		{
+			Turret->ManagerIndex = INDEX_NONE;
+		}
+	}
+
+	Turrets.Empty();
+	YawComponents.Empty();
+	PitchComponents.Empty();
+	InvActorRotations.Empty();
+	PivotLocations.Empty();
+	TargetLocations.Empty();
+	TargetVelocities.Empty();
+	MuzzleLocations.Empty();
+	LeadTarget.Empty();
+	ProjectileSpeeds.Empty();
+	ProjectileGravities.Empty();
+	AimLocations.Empty();
+	AimTargets.Empty();
+	AimToleranceCosines.Empty();
+	AimReady.Empty();
+	HasTarget.Empty();
+	DesiredYaws.Empty();
+	DesiredPitches.Empty();
+	Yaws.Empty();
+	Pitches.Empty();
+	RotationChanges.Empty();
+	RotationSpeeds.Empty();
+	MinPitches.Empty();
+	MaxPitches.Empty();
+	LODs.Empty();
+	States.Empty();
+	PendingDeltaTimes.Empty();
+	DeltaTimes.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTurretManagerSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UTurretManagerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTurretManagerSubsystem, STATGROUP_Tickables);
+}
+
+void UTurretManagerSubsystem::RegisterTurret(ATurret* Turret)
+{
+	if (Turret == nullptr || Turret->ManagerIndex != INDEX_NONE)
+	{
+		return;
+	}
+
+	USceneComponent* YawComp = Turret->GetYawComponent();
+	USceneComponent* PitchComp = Turret->GetPitchComponent();
+	const FTurretInfo& TurretInfo = Turret->GetTurretInfo();
+
+	Turret->ManagerIndex = Turrets.Add(Turret);
+	YawComponents.Add(YawComp);
+	PitchComponents.Add(PitchComp);
+	InvActorRotations.Add(Turret->GetActorQuat().Inverse());
+	PivotLocations.Add(PitchComp->GetComponentLocation());
+	TargetLocations.Add(FVector::ZeroVector);
+	TargetVelocities.Add(FVector::ZeroVector);
+	MuzzleLocations.Add(FVector::ZeroVector);
+	LeadTarget.Add(0);
+	ProjectileSpeeds.Add(0.0f);
+	ProjectileGravities.Add(0.0f);
+	AimLocations.Add(FVector::ZeroVector);
+	AimTargets.AddDefaulted();
+	AimToleranceCosines.Add(FMath::Cos(FMath::DegreesToRadians(Turret->LeadAimTolerance)));
+	AimReady.Add(0);
+	HasTarget.Add(0);
+	DesiredYaws.Add(0.0f);
+	DesiredPitches.Add(0.0f);
+	Yaws.Add(YawComp->GetRelativeRotation().Yaw);
+	Pitches.Add(PitchComp->GetRelativeRotation().Pitch);
+	RotationChanges.Add(0);
+	RotationSpeeds.Add(TurretInfo.RotationSpeed);
+	MinPitches.Add(TurretInfo.MinPitch);
+	MaxPitches.Add(TurretInfo.MaxPitch);
+	LODs.Add(static_cast<uint8>(ETurretLOD::High));
+	States.Add(static_cast<uint8>(Turret->GetState()));
+	PendingDeltaTimes.Add(0.0f);
+	DeltaTimes.Add(0.0f);
+
+	++LODCounts[static_cast<int32>(ETurretLOD::High)];
+	++StateCounts[static_cast<int32>(Turret->GetState())];
+}
+
+void UTurretManagerSubsystem::UnregisterTurret(ATurret* Turret)
+{
+	if (Turret == nullptr || Turrets.IsValidIndex(Turret->ManagerIndex) == false || Turrets[Turret->ManagerIndex] != Turret)
+	{
+		return;
+	}
+
+	const int32 Index = Turret->ManagerIndex;
+	Turret->ManagerIndex = INDEX_NONE;
+
+	--LODCounts[LODs[Index]];
+	--StateCounts[States[Index]];
+
+	Turrets.RemoveAtSwap(Index, 1, false);
+	YawComponents.RemoveAtSwap(Index, 1, false);
+	PitchComponents.RemoveAtSwap(Index, 1, false);
+	InvActorRotations.RemoveAtSwap(Index, 1, false);
+	PivotLocations.RemoveAtSwap(Index, 1, false);
+	TargetLocations.RemoveAtSwap(Index, 1, false);
+	TargetVelocities.RemoveAtSwap(Index, 1, false);
+	MuzzleLocations.RemoveAtSwap(Index, 1, false);
+	LeadTarget.RemoveAtSwap(Index, 1, false);
+	ProjectileSpeeds.RemoveAtSwap(Index, 1, false);
+	ProjectileGravities.RemoveAtSwap(Index, 1, false);
+	AimLocations.RemoveAtSwap(Index, 1, false);
+	AimTargets.RemoveAtSwap(Index, 1, false);
+	AimToleranceCosines.RemoveAtSwap(Index, 1, false);
+	AimReady.RemoveAtSwap(Index, 1, false);
+	HasTarget.RemoveAtSwap(Index, 1, false);
+	DesiredYaws.RemoveAtSwap(Index, 1, false);
+	DesiredPitches.RemoveAtSwap(Index, 1, false);
+	Yaws.RemoveAtSwap(Index, 1, false);
+	Pitches.RemoveAtSwap(Index, 1, false);
+	RotationChanges.RemoveAtSwap(Index, 1, false);
+	RotationSpeeds.RemoveAtSwap(Index, 1, false);
+	MinPitches.RemoveAtSwap(Index, 1, false);
+	MaxPitches.RemoveAtSwap(Index, 1, false);
+	LODs.RemoveAtSwap(Index, 1, false);
+	States.RemoveAtSwap(Index, 1, false);
+	PendingDeltaTimes.RemoveAtSwap(Index, 1, false);
+	DeltaTimes.RemoveAtSwap(Index, 1, false);
+
+	// The last turret is moved into the removed slot
+	if (Turrets.IsValidIndex(Index))
+	{
+		Turrets[Index]->ManagerIndex = Index;
+	}
+}
+
+void UTurretManagerSubsystem::RefreshTurretInfo(const ATurret* Turret)
+{
+	if (Turret == nullptr || Turrets.IsValidIndex(Turret->ManagerIndex) == false || Turrets[Turret->ManagerIndex] != Turret)
+	{
+		return;
+	}
+
+	const int32 Index = Turret->ManagerIndex;
+	const FTurretInfo& TurretInfo = Turret->GetTurretInfo();
+	RotationSpeeds[Index] = TurretInfo.RotationSpeed;
+	MinPitches[Index] = TurretInfo.MinPitch;
+	MaxPitches[Index] = TurretInfo.MaxPitch;
+}
+
+void UTurretManagerSubsystem::RefreshTurretInfos()
+{
+	for (const ATurret* Turret : Turrets)
+	{
+		RefreshTurretInfo(Turret);
+	}
+}
+
+void UTurretManagerSubsystem::AdvanceTurret(const ATurret* Turret, float DeltaTime)
+{
+	if (Turret && Turrets.IsValidIndex(Turret->ManagerIndex))
+	{
+		PendingDeltaTimes[Turret->ManagerIndex] += DeltaTime;
+	}
+}
+
+void UTurretManagerSubsystem::SetTurretState(const ATurret* Turret, ETurretState NewState)
+{
+	if (Turret == nullptr || Turrets.IsValidIndex(Turret->ManagerIndex) == false || Turrets[Turret->ManagerIndex] != Turret)
+	{
+		return;
+	}
+
+	uint8& State = States[Turret->ManagerIndex];
+	--StateCounts[State];
+	State = static_cast<uint8>(NewState);
+	++StateCounts[State];
+}
+
+void UTurretManagerSubsystem::WakeTurrets(const FVector& Center, float Radius)
+{
+	const float RadiusSquared = FMath::Square(Radius);
+
+	// Waking up may change the arrays through the turret callbacks, so the turrets are collected first
+	TArray<ATurret*, TInlineAllocator<64>> WokenTurrets;
+	for (int32 i = 0; i < Turrets.Num(); ++i)
+	{
+		if (States[i] == static_cast<uint8>(ETurretState::Dormant) && FVector::DistSquared(PivotLocations[i], Center) <= RadiusSquared)
+		{
+			WokenTurrets.Add(Turrets[i]);
+		}
+	}
+
+	for (ATurret* Turret : WokenTurrets)
+	{
+		Turret->Wake();
+	}
+}
+
+bool UTurretManagerSubsystem::GetAimResult(const ATurret* Turret, FVector& OutAimLocation, bool& bOutAimed) const
+{
+	if (Turret == nullptr || Turrets.IsValidIndex(Turret->ManagerIndex) == false || HasTarget[Turret->ManagerIndex] == 0)
+	{
+		return false;
+	}
+
+	// The turret has switched targets since the last update, e.g. a low LOD turret that wasn't updated this frame
+	if (AimTargets[Turret->ManagerIndex] != Turret->GetCurrentTarget())
+	{
+		return false;
+	}
+
+	OutAimLocation = AimLocations[Turret->ManagerIndex];
+	bOutAimed = AimReady[Turret->ManagerIndex] != 0;
+	return true;
+}
+
+void UTurretManagerSubsystem::Tick(float DeltaTime)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_ManagerTick);
+	TURRETAI_PROFILE_SCOPE(Tick);
+
+	Super::Tick(DeltaTime);
+
+	PublishStats();
+
+	if (Turrets.IsEmpty())
+	{
+		return;
+	}
+
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	LODUpdateTime -= DeltaTime;
+	if (LODUpdateTime <= 0.0f)
+	{
+		LODUpdateTime = LODUpdateInterval;
+		UpdateLODs();
+	}
+
+	UpdateDeltaTimes(DeltaTime);
+	GatherTargets();
+	UpdateRotations(GetNumTasks());
+	ApplyRotations();
+
+	++FrameCounter;
+	++NumStatFrames;
+	TickCycles += FPlatformTime::Cycles() - StartCycles;
+}
+
+void UTurretManagerSubsystem::PublishStats() const
+{
+	int32 NumProjectiles = 0;
+	if (const UProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+	{
+		NumProjectiles += ProjectilePool->GetNumActiveProjectiles();
+	}
+
+	if (const UProjectileSimulationSubsystem* ProjectileSimulation = GetWorld()->GetSubsystem<UProjectileSimulationSubsystem>())
+	{
+		NumProjectiles += ProjectileSimulation->GetNumProjectiles();
+	}
+
+	FTurretStats::PublishFrame(Turrets.Num(), NumProjectiles);
+
+	SET_DWORD_STAT(STAT_TurretAI_DormantTurrets, GetNumTurretsInState(ETurretState::Dormant));
+	SET_DWORD_STAT(STAT_TurretAI_IdleSweepTurrets, GetNumTurretsInState(ETurretState::IdleSweep));
+	SET_DWORD_STAT(STAT_TurretAI_AcquiringTurrets, GetNumTurretsInState(ETurretState::Acquiring));
+	SET_DWORD_STAT(STAT_TurretAI_EngagingTurrets, GetNumTurretsInState(ETurretState::Engaging));
+	SET_DWORD_STAT(STAT_TurretAI_DestroyedTurrets, GetNumTurretsInState(ETurretState::Destroyed));
+}
+
+void UTurretManagerSubsystem::UpdateLODs()
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_UpdateLODs);
+
+	// On the server every player counts, on clients only the local players have a view point
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	TArray<FVector, TInlineAllocator<4>> ViewDirections;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APlayerController* PlayerController = It->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+			ViewDirections.Add(ViewRotation.Vector());
+		}
+	}
+
+	const float MediumDistanceSquared = FMath::Square(MediumLODDistance);
+	const float LowDistanceSquared = FMath::Square(LowLODDistance);
+	const float ViewConeCos = FMath::Cos(FMath::DegreesToRadians(ViewConeHalfAngle));
+	constexpr int32 LowestLOD = static_cast<int32>(ETurretLOD::Low);
+
+	FMemory::Memzero(LODCounts);
+
+	// Without any view point, e.g. on a dedicated server without players, the turrets are not reduced
+	const int32 DefaultLOD = ViewLocations.IsEmpty() ? 0 : LowestLOD;
+
+	for (int32 i = 0; i < Turrets.Num(); ++i)
+	{
+		int32 LOD = DefaultLOD;
+		for (int32 ViewIndex = 0; ViewIndex < ViewLocations.Num() && LOD > 0; ++ViewIndex)
+		{
+			const FVector ToTurret = PivotLocations[i] - ViewLocations[ViewIndex];
+			const float DistanceSquared = ToTurret.SizeSquared();
+
+			int32 ViewLOD = DistanceSquared < MediumDistanceSquared ? 0 : DistanceSquared < LowDistanceSquared ? 1 : 2;
+
+			// Turrets behind the player are not seen, but still need to be responsive when the player turns around
+			if (FVector::DotProduct(ToTurret.GetSafeNormal(), ViewDirections[ViewIndex]) < ViewConeCos)
+			{
+				ViewLOD = FMath::Min(ViewLOD + 1, LowestLOD);
+			}
+
+			LOD = FMath::Min(LOD, ViewLOD);
+		}
+
+		LODs[i] = static_cast<uint8>(LOD);
+		++LODCounts[LOD];
+	}
+}
+
+void UTurretManagerSubsystem::UpdateDeltaTimes(float DeltaTime)
+{
+	const int32 FrameIntervals[] = { 1, FMath::Max(MediumLODFrameInterval, 1), FMath::Max(LowLODFrameInterval, 1) };
+
+	for (int32 i = 0; i < Turrets.Num(); ++i)
+	{
+		// Dormant turrets hold their rotation until they are woken up
+		if (States[i] == static_cast<uint8>(ETurretState::Dormant))
+		{
+			PendingDeltaTimes[i] = 0.0f;
+			DeltaTimes[i] = 0.0f;
+			continue;
+		}
+
+		PendingDeltaTimes[i] += DeltaTime;
+
+		// Idle sweeps of low LOD turrets are cosmetic only, they resume from where they stopped when the LOD rises
+		const ETurretLOD LOD = static_cast<ETurretLOD>(LODs[i]);
+		if (LOD == ETurretLOD::Low && Turrets[i]->GetCurrentTarget() == nullptr)
+		{
+			PendingDeltaTimes[i] = 0.0f;
+			DeltaTimes[i] = 0.0f;
+			continue;
+		}
+
+		// Offset by the index so the turrets of the same LOD are spread over the frames
+		if ((FrameCounter + i) % FrameIntervals[LODs[i]] == 0)
+		{
+			DeltaTimes[i] = PendingDeltaTimes[i];
+			PendingDeltaTimes[i] = 0.0f;
+		}
+		else
+		{
+			DeltaTimes[i] = 0.0f;
+		}
+	}
+}
+
+void UTurretManagerSubsystem::GatherTargets()
+{
+	for (int32 i = 0; i < Turrets.Num(); ++i)
+	{
+		if (DeltaTimes[i] == 0.0f)
+		{
+			continue;
+		}
+
+		const ATurret* Turret = Turrets[i];
+		if (const AActor* Target = Turret->GetCurrentTarget())
+		{
+			// Homing projectiles follow the target, so there is no need to lead it
+			TargetLocations[i] = Target->GetActorLocation();
+			TargetVelocities[i] = Target->GetVelocity();
+			MuzzleLocations[i] = Turret->BarrelMesh->GetSocketLocation("ProjectileSocket");
+			LeadTarget[i] = Turret->GetTurretInfo().HasFlag(ETurretAbility::Homing) ? 0 : 1;
+			ProjectileSpeeds[i] = Turret->ProjectileSpeed;
+			ProjectileGravities[i] = Turret->ProjectileGravityZ;
+			AimTargets[i] = Target;
+			HasTarget[i] = 1;
+		}
+		else
+		{
+			const FRotator& RandomRotation = Turret->GetRandomRotation();
+			DesiredYaws[i] = RandomRotation.Yaw;
+			DesiredPitches[i] = RandomRotation.Pitch;
+			HasTarget[i] = 0;
+			AimReady[i] = 0;
+			AimTargets[i].Reset();
+		}
+	}
+}
+
+int32 UTurretManagerSubsystem::GetNumTasks() const
+{
+	if (bParallelUpdate == false || FApp::ShouldUseThreadingForPerformance() == false)
+	{
+		return 1;
+	}
+
+	const int32 MaxTasks = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	return FMath::Clamp(Turrets.Num() / FMath::Max(MinTurretsPerTask, 1), 1, MaxTasks);
+}
+
+void UTurretManagerSubsystem::UpdateRotations(int32 NumTasks)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_UpdateRotations);
+
+	const int32 Num = Turrets.Num();
+	const int32 NumPerTask = FMath::DivideAndRoundUp(Num, FMath::Max(NumTasks, 1));
+
+	// The game thread waits for the tasks, so the actors can't change while the snapshot is read
+	ParallelFor(FMath::DivideAndRoundUp(Num, NumPerTask), [this, Num, NumPerTask](int32 TaskIndex)
+	{
+		UpdateRotationRange(TaskIndex * NumPerTask, FMath::Min((TaskIndex + 1) * NumPerTask, Num));
+	}, NumTasks > 1 ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+}
+
+void UTurretManagerSubsystem::UpdateRotationRange(int32 StartIndex, int32 EndIndex)
+{
+	// Lead the targets and convert them to the desired rotation in the turret space
+	for (int32 i = StartIndex; i < EndIndex; ++i)
+	{
+		if (HasTarget[i] && DeltaTimes[i] > 0.0f)
+		{
+			FVector AimLocation = TargetLocations[i];
+			if (LeadTarget[i])
+			{
+				float TimeOfFlight;
+				FTurretAimSolver::SolveIntercept(MuzzleLocations[i], TargetLocations[i], TargetVelocities[i], ProjectileSpeeds[i], ProjectileGravities[i], AimLocation, TimeOfFlight);
+			}
+
+			AimLocations[i] = AimLocation;
+
+			const FRotator TargetRotation = InvActorRotations[i].RotateVector(AimLocation - PivotLocations[i]).Rotation();
+			DesiredYaws[i] = TargetRotation.Yaw;
+			DesiredPitches[i] = TargetRotation.Pitch;
+		}
+	}
+
+	// Constant speed interpolation, same as FMath::RInterpConstantTo but per axis over flat arrays
+	float* RESTRICT YawData = Yaws.GetData();
+	float* RESTRICT PitchData = Pitches.GetData();
+	const float* RESTRICT DesiredYawData = DesiredYaws.GetData();
+	const float* RESTRICT DesiredPitchData = DesiredPitches.GetData();
+	const float* RESTRICT SpeedData = RotationSpeeds.GetData();
+	const float* RESTRICT MinPitchData = MinPitches.GetData();
+	const float* RESTRICT MaxPitchData = MaxPitches.GetData();
+	const float* RESTRICT DeltaTimeData = DeltaTimes.GetData();
+	uint8* RESTRICT ChangeData = RotationChanges.GetData();
+
+	// Skipped turrets have a zero delta time, so they keep their rotation
+	for (int32 i = StartIndex; i < EndIndex; ++i)
+	{
+		const float Step = FMath::Min(SpeedData[i] * DeltaTimeData[i], 180.0f);
+		uint8 Changes = 0;
+
+		// Converged axes are left untouched, so the turret can skip its transform update
+		const float DeltaYaw = FRotator::NormalizeAxis(DesiredYawData[i] - YawData[i]);
+		if (Step > 0.0f && FMath::Abs(DeltaYaw) > ConvergedAngle)
+		{
+			YawData[i] = FRotator::NormalizeAxis(YawData[i] + FMath::Clamp(DeltaYaw, -Step, Step));
+			Changes |= YawChangedFlag;
+		}
+
+		const float DeltaPitch = FRotator::NormalizeAxis(DesiredPitchData[i] - PitchData[i]);
+		const float NewPitch = FMath::ClampAngle(PitchData[i] + FMath::Clamp(DeltaPitch, -Step, Step), MinPitchData[i], MaxPitchData[i]);
+		if (Step > 0.0f && FMath::Abs(FRotator::NormalizeAxis(NewPitch - PitchData[i])) > ConvergedAngle)
+		{
+			PitchData[i] = NewPitch;
+			Changes |= PitchChangedFlag;
+		}
+
+		ChangeData[i] = Changes;
+	}
+
+	// Fire decision of the lead aim, the barrel direction is taken from the new rotation in the turret space
+	for (int32 i = StartIndex; i < EndIndex; ++i)
+	{
+		if (HasTarget[i] && DeltaTimes[i] > 0.0f)
+		{
+			const FVector AimDirection = InvActorRotations[i].RotateVector(AimLocations[i] - MuzzleLocations[i]).GetSafeNormal();
+			AimReady[i] = FVector::DotProduct(FRotator(Pitches[i], Yaws[i], 0.0f).Vector(), AimDirection) >= AimToleranceCosines[i] ? 1 : 0;
+		}
+	}
+}
+
+void UTurretManagerSubsystem::ApplyRotations()
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_ApplyRotations);
+
+	const bool bMeasureCost = CVarTurretLODMeasureCost.GetValueOnGameThread() != 0;
+
+	for (int32 i = 0; i < Turrets.Num(); ++i)
+	{
+		if (DeltaTimes[i] == 0.0f)
+		{
+			continue;
+		}
+
+		// Turrets that reached their desired rotation don't pay for the transform propagation
+		const uint8 Changes = bSkipConvergedRotations ? RotationChanges[i] : YawChangedFlag | PitchChangedFlag;
+		if (Changes == 0)
+		{
+			++LODConvergedCounts[LODs[i]];
+			continue;
+		}
+
+		// Moving the components is the main cost of the update, so it can be measured per LOD
+		const uint32 StartCycles = bMeasureCost ? FPlatformTime::Cycles() : 0;
+
+		USceneComponent* YawComp = YawComponents[i];
+		USceneComponent* PitchComp = PitchComponents[i];
+
+		if (YawComp == PitchComp)
+		{
+			PitchComp->SetRelativeRotation(FRotator(Pitches[i], Yaws[i], 0.0f));
+		}
+		else if (Changes & YawChangedFlag)
+		{
+			// The pitch is written without an update, the yaw update moves the attached pitch component with it in one pass
+			PitchComp->SetRelativeRotation_Direct(FRotator(Pitches[i], 0.0f, 0.0f));
+			YawComp->SetRelativeRotation(FRotator(0.0f, Yaws[i], 0.0f));
+		}
+		else
+		{
+			PitchComp->SetRelativeRotation(FRotator(Pitches[i], 0.0f, 0.0f));
+		}
+
+		if (bMeasureCost)
+		{
+			LODCycles[LODs[i]] += FPlatformTime::Cycles() - StartCycles;
+		}
+
+		++LODUpdateCounts[LODs[i]];
+	}
+}
+
+void UTurretManagerSubsystem::LogLODStats()
+{
+	static const TCHAR* LODNames[] = { TEXT("High"), TEXT("Medium"), TEXT("Low") };
+	const int32 Frames = FMath::Max(NumStatFrames, 1);
+
+	UE_LOG(LogTurretAI, Log, TEXT("Turret manager: %d turrets, %d frames, %.3f ms per frame"),
+		Turrets.Num(), NumStatFrames, FPlatformTime::ToMilliseconds64(TickCycles) / Frames);
+
+	UE_LOG(LogTurretAI, Log, TEXT("Turret states: %d dormant, %d idle sweep, %d acquiring, %d engaging, %d destroyed"),
+		GetNumTurretsInState(ETurretState::Dormant), GetNumTurretsInState(ETurretState::IdleSweep), GetNumTurretsInState(ETurretState::Acquiring),
+		GetNumTurretsInState(ETurretState::Engaging), GetNumTurretsInState(ETurretState::Destroyed));
+
+	for (int32 LOD = 0; LOD < static_cast<int32>(ETurretLOD::Num); ++LOD)
+	{
+		UE_LOG(LogTurretAI, Log, TEXT("%s LOD: %d turrets, %.1f updates per frame, %.1f converged skips per frame, %.3f ms per frame"),
+			LODNames[LOD], LODCounts[LOD], static_cast<float>(LODUpdateCounts[LOD]) / Frames, static_cast<float>(LODConvergedCounts[LOD]) / Frames,
+			FPlatformTime::ToMilliseconds64(LODCycles[LOD]) / Frames);
+	}
+
+	FMemory::Memzero(LODUpdateCounts);
+	FMemory::Memzero(LODConvergedCounts);
+	FMemory::Memzero(LODCycles);
+	TickCycles = 0;
+	NumStatFrames = 0;
+}
+
+void UTurretManagerSubsystem::RunParallelBenchmark(int32 NumIterations)
+{
+	if (Turrets.IsEmpty())
+	{
+		UE_LOG(LogTurretAI, Warning, TEXT("Parallel aim benchmark needs turrets in the world, start the combat benchmark first"));
+		return;
+	}
+
+	NumIterations = FMath::Max(NumIterations, 1);
+
+	// Every turret is updated on each iteration, the rotations are restored afterwards so the benchmark doesn't move the turrets
+	const TArray<float> SavedDeltaTimes = DeltaTimes;
+	const TArray<float> SavedYaws = Yaws;
+	const TArray<float> SavedPitches = Pitches;
+
+	for (float& TurretDeltaTime : DeltaTimes)
+	{
+		TurretDeltaTime = 1.0f / 60.0f;
+	}
+	GatherTargets();
+
+	const int32 MaxTasks = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	double SingleTaskTime = 0.0;
+
+	for (int32 NumTasks = 1; NumTasks <= MaxTasks; NumTasks = NumTasks < MaxTasks ? FMath::Min(NumTasks * 2, MaxTasks) : MaxTasks + 1)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			UpdateRotations(NumTasks);
+		}
+		const double TaskTime = (FPlatformTime::Seconds() - StartTime) / NumIterations;
+
+		if (NumTasks == 1)
+		{
+			SingleTaskTime = TaskTime;
+		}
+
+		UE_LOG(LogTurretAI, Display, TEXT("Parallel aim benchmark: %d turrets, %d tasks, %.3f ms per update, %.2fx speedup"),
+			Turrets.Num(), NumTasks, TaskTime * 1000.0, SingleTaskTime / FMath::Max(TaskTime, UE_SMALL_NUMBER));
+	}
+
+	DeltaTimes = SavedDeltaTimes;
+	Yaws = SavedYaws;
+	Pitches = SavedPitches;
+}
@@ -0,0 +1,878 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/TurretProxySubsystem.h"
+
+#include "Actors/Projectile.h"
+#include "Actors/Turret.h"
+#include "Actors/TurretProxyAimStream.h"
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/SphereComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshSocket.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Subsystems/ProjectileSimulationSubsystem.h"
+#include "Subsystems/TurretAssetSubsystem.h"
+#include "Subsystems/TurretTargetSubsystem.h"
+#include "TurretAI.h"
+#include "TurretAIProfiling.h"
+
+DECLARE_CYCLE_STAT(TEXT("Turret Proxy Tick"), STAT_TurretAI_ProxyTick, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Proxy Targets"), STAT_TurretAI_ProxyTargets, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Proxy Rotations"), STAT_TurretAI_ProxyRotations, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Proxy Fire"), STAT_TurretAI_ProxyFire, STATGROUP_TurretAI);
+DECLARE_CYCLE_STAT(TEXT("Proxy Instances"), STAT_TurretAI_ProxyInstances, STATGROUP_TurretAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Turret Proxies"), STAT_TurretAI_Proxies, STATGROUP_TurretAI);
+
+static FAutoConsoleCommandWithWorld TurretProxyStatsCommand(
+	TEXT("TurretAI.Proxy.Stats"),
+	TEXT("Writes the number of proxy turrets and the number of proxies that are promoted to turret actors to the log"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](const UWorld* World)
+	{
+		if (const UTurretProxySubsystem* ProxySubsystem = World ? World->GetSubsystem<UTurretProxySubsystem>() : nullptr)
+		{
+			UE_LOG(LogTurretAI, Log, TEXT("Turret proxies: %d, Promoted %d"), ProxySubsystem->GetNumProxies(), ProxySubsystem->GetNumPromotedProxies());
+		}
+	}));
+
+/** Bits of the instances of a proxy that have changed since the last upload */
+static constexpr uint8 RotationDirtyFlag = 1 << 0;
+static constexpr uint8 BaseDirtyFlag = 1 << 1;
+
+/** Transform of the socket of the parent mesh that the component is attached to */
+static FTransform GetAttachSocketTransform(const USceneComponent* Component)
+{
+	const UStaticMeshComponent* Parent = Cast<UStaticMeshComponent>(Component->GetAttachParent());
+	const UStaticMeshSocket* Socket = Parent && Parent->GetStaticMesh() ? Parent->GetStaticMesh()->FindSocket(Component->GetAttachSocketName()) : nullptr;
+	return Socket ? FTransform(Socket->RelativeRotation, Socket->RelativeLocation, Socket->RelativeScale) : FTransform::Identity;
+}
+
+static FTransform GetMeshSocketTransform(const UStaticMeshComponent* Component, FName SocketName)
+{
+	const UStaticMeshSocket* Socket = Component->GetStaticMesh() ? Component->GetStaticMesh()->FindSocket(SocketName) : nullptr;
+	return Socket ? FTransform(Socket->RelativeRotation, Socket->RelativeLocation, Socket->RelativeScale) : FTransform::Identity;
+}
+
+void FTurretProxyGroup::RemoveAtSwap(int32 Index)
+{
+	// The last proxy takes the index of the removed one
+	IdIndices.Remove(Ids[Index]);
+	if (Index != Ids.Num() - 1)
+	{
+		IdIndices.Add(Ids.Last(), Index);
+	}
+
+	Transforms.RemoveAtSwap(Index, 1, false);
+	InvRotations.RemoveAtSwap(Index, 1, false);
+	Yaws.RemoveAtSwap(Index, 1, false);
+	Pitches.RemoveAtSwap(Index, 1, false);
+	Cooldowns.RemoveAtSwap(Index, 1, false);
+	Targets.RemoveAtSwap(Index, 1, false);
+	TargetLocations.RemoveAtSwap(Index, 1, false);
+	Actors.RemoveAtSwap(Index, 1, false);
+	Promoted.RemoveAtSwap(Index, 1, false);
+	Ids.RemoveAtSwap(Index, 1, false);
+	AimIndices.RemoveAtSwap(Index, 1, false);
+	AimChanged.RemoveAtSwap(Index, 1, false);
+	DirtyInstances.RemoveAtSwap(Index, 1, false);
+}
+
+void UTurretProxySubsystem::Deinitialize()
+{
+	if (Groups.Num() > 0)
+	{
+		if (UTurretTargetSubsystem* TargetSubsystem = GetWorld()->GetSubsystem<UTurretTargetSubsystem>())
+		{
+			TargetSubsystem->RemoveGridUser();
+		}
+	}
+
+	Groups.Empty();
+	VisualsActor = nullptr;
+	AimStream = nullptr;
+	ProxyGroupIndices.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTurretProxySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UTurretProxySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTurretProxySubsystem, STATGROUP_Tickables);
+}
+
+int32 UTurretProxySubsystem::GetNumProxies() const
+{
+	int32 NumProxies = 0;
+	for (const FTurretProxyGroup& Group : Groups)
+	{
+		NumProxies += Group.Num();
+	}
+
+	return NumProxies;
+}
+
+int32 UTurretProxySubsystem::GetNumPromotedProxies() const
+{
+	int32 NumPromoted = 0;
+	for (const FTurretProxyGroup& Group : Groups)
+	{
+		for (const uint8 bPromoted : Group.Promoted)
+		{
+			NumPromoted += bPromoted;
+		}
+	}
+
+	return NumPromoted;
+}
+
+bool UTurretProxySubsystem::AddProxy(TSubclassOf<ATurret> TurretClass, const FTransform& Transform)
+{
+	// Clients create the proxies that the server replicates
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogTurretAI, Warning, TEXT("Turret proxies can only be added on the server"));
+		return false;
+	}
+
+	const int32 ProxyId = NextProxyId;
+	FTurretProxyGroup* Group = AddProxyData(TurretClass, Transform, ProxyId);
+	if (Group == nullptr)
+	{
+		return false;
+	}
+
+	++NextProxyId;
+
+	// The stream is spawned with the first group
+	Group->AimIndices.Last() = AimStream ? AimStream->AddAim(ProxyId, TurretClass, Transform) : INDEX_NONE;
+
+	return true;
+}
+
+void UTurretProxySubsystem::AddReplicatedProxy(int32 ProxyId, TSubclassOf<ATurret> TurretClass, const FTransform& Transform, const FTurretAimState& AimState, ATurret* Turret)
+{
+	if (AddProxyData(TurretClass, Transform, ProxyId))
+	{
+		ApplyProxyAim(ProxyId, AimState, Turret);
+	}
+}
+
+void UTurretProxySubsystem::RemoveAllProxies()
+{
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	for (FTurretProxyGroup& Group : Groups)
+	{
+		for (int32 i = Group.Num() - 1; i >= 0; --i)
+		{
+			// Removed with the proxy, so no debris or effects
+			if (ATurret* Turret = Group.Actors[i].Get())
+			{
+				Turret->DemoteToProxy();
+			}
+
+			RemoveProxyAt(Group, i);
+		}
+	}
+}
+
+FTurretProxyGroup* UTurretProxySubsystem::AddProxyData(TSubclassOf<ATurret> TurretClass, const FTransform& Transform, int32 ProxyId)
+{
+	FTurretProxyGroup* Group = TurretClass ? FindOrAddGroup(TurretClass) : nullptr;
+	if (Group == nullptr)
+	{
+		return nullptr;
+	}
+
+	Group->Transforms.Add(Transform);
+	Group->InvRotations.Add(Transform.GetRotation().Inverse());
+	Group->Yaws.Add(0.0f);
+	Group->Pitches.Add(0.0f);
+	Group->Cooldowns.Add(0.0f);
+	Group->Targets.AddDefaulted();
+	Group->TargetLocations.Add(FVector::ZeroVector);
+	Group->Actors.AddDefaulted();
+	Group->Promoted.Add(0);
+	Group->DirtyInstances.Add(RotationDirtyFlag | BaseDirtyFlag);
+
+	Group->IdIndices.Add(ProxyId, Group->Ids.Add(ProxyId));
+	Group->AimIndices.Add(INDEX_NONE);
+	Group->AimChanged.Add(0);
+
+	ProxyGroupIndices.Add(ProxyId, static_cast<int32>(Group - Groups.GetData()));
+
+	return Group;
+}
+
+void UTurretProxySubsystem::RemoveProxyAt(FTurretProxyGroup& Group, int32 Index)
+{
+	ProxyGroupIndices.Remove(Group.Ids[Index]);
+	RemoveProxyAim(Group.AimIndices[Index]);
+	Group.RemoveAtSwap(Index);
+}
+
+void UTurretProxySubsystem::ApplyProxyAim(int32 ProxyId, const FTurretAimState& AimState, ATurret* Turret)
+{
+	// Proxies of a class that isn't loaded on this client are not created
+	const int32* GroupIndex = ProxyGroupIndices.Find(ProxyId);
+	FTurretProxyGroup* Group = GroupIndex ? &Groups[*GroupIndex] : nullptr;
+	const int32* Index = Group ? Group->IdIndices.Find(ProxyId) : nullptr;
+	if (Index == nullptr)
+	{
+		return;
+	}
+
+	// Same rule as the server, the proxy is hidden while its turret actor exists
+	const uint8 bPromoted = Turret != nullptr;
+	Group->DirtyInstances[*Index] |= Group->Promoted[*Index] != bPromoted ? RotationDirtyFlag | BaseDirtyFlag : RotationDirtyFlag;
+	Group->Promoted[*Index] = bPromoted;
+	Group->Actors[*Index] = Turret;
+
+	// Same as the turret actors, the proxy starts from the aim of the server and turns toward the target itself
+	const FRotator Rotation = AimState.GetRotation();
+	Group->Yaws[*Index] = Rotation.Yaw;
+	Group->Pitches[*Index] = Rotation.Pitch;
+	Group->Targets[*Index] = AimState.Target;
+}
+
+void UTurretProxySubsystem::RemoveProxy(int32 ProxyId)
+{
+	const int32* GroupIndex = ProxyGroupIndices.Find(ProxyId);
+	FTurretProxyGroup* Group = GroupIndex ? &Groups[*GroupIndex] : nullptr;
+	if (const int32* Index = Group ? Group->IdIndices.Find(ProxyId) : nullptr)
+	{
+		RemoveProxyAt(*Group, *Index);
+	}
+}
+
+FTurretProxyGroup* UTurretProxySubsystem::FindOrAddGroup(TSubclassOf<ATurret> TurretClass)
+{
+	for (FTurretProxyGroup& Group : Groups)
+	{
+		if (Group.TurretClass == TurretClass)
+		{
+			return &Group;
+		}
+	}
+
+	const ATurret* Defaults = TurretClass->GetDefaultObject<ATurret>();
+	UStaticMeshComponent* BaseMesh = Defaults->BaseMesh;
+	UStaticMeshComponent* YawMesh = Defaults->GetYawComponent();
+	UStaticMeshComponent* PitchMesh = Defaults->GetPitchComponent();
+
+	// Parts are placed with the same hierarchy as the turret manager rotates them
+	const bool bSeparatePitch = YawMesh != PitchMesh;
+	if (YawMesh->GetAttachParent() != BaseMesh || (bSeparatePitch && PitchMesh->GetAttachParent() != YawMesh))
+	{
+		UE_LOG(LogTurretAI, Warning, TEXT("%s can't be used as a turret proxy, the yaw and pitch parts have a different hierarchy"), *GetNameSafe(TurretClass));
+		return nullptr;
+	}
+
+	// Proxies find their targets in the grid of the target subsystem
+	if (Groups.IsEmpty())
+	{
+		if (UTurretTargetSubsystem* TargetSubsystem = GetWorld()->GetSubsystem<UTurretTargetSubsystem>())
+		{
+			TargetSubsystem->AddGridUser();
+		}
+	}
+
+	FTurretProxyGroup& Group = Groups.AddDefaulted_GetRef();
+	Group.TurretClass = TurretClass;
+	Group.bSeparatePitch = bSeparatePitch;
+	Group.DetectionRadius = Defaults->Detector->GetScaledSphereRadius();
+	Group.BaseTransform = BaseMesh->GetRelativeTransform();
+	Group.YawTransform = YawMesh->GetRelativeTransform();
+	Group.PitchTransform = PitchMesh->GetRelativeTransform();
+	Group.YawSocket = GetAttachSocketTransform(YawMesh);
+	Group.PitchSocket = bSeparatePitch ? GetAttachSocketTransform(PitchMesh) : FTransform::Identity;
+	Group.MuzzleSocket = GetMeshSocketTransform(PitchMesh, "ProjectileSocket");
+
+	// Replaced by the info of the archetype when it is loaded, the proxies wait for the assets without blocking the game thread
+	Group.TurretInfo = Defaults->TurretInfo;
+	LoadGroupAssets(Groups.Num() - 1);
+
+	// Pivot of the aim when the turret has no rotation, same as the pitch component location used by the turret manager
+	const FTransform YawPivot = FTransform(Group.YawTransform.GetLocation()) * Group.YawSocket * Group.BaseTransform;
+	Group.PivotOffset = bSeparatePitch ? (FTransform(Group.PitchTransform.GetLocation()) * Group.PitchSocket * YawPivot).GetLocation() : YawPivot.GetLocation();
+
+	UWorld* World = GetWorld();
+	if (AimStream == nullptr && (World->GetNetMode() == NM_DedicatedServer || World->GetNetMode() == NM_ListenServer))
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		AimStream = World->SpawnActor<ATurretProxyAimStream>(SpawnParams);
+	}
+
+	// Visuals are not needed on dedicated servers
+	if (World->GetNetMode() == NM_DedicatedServer)
+	{
+		return &Group;
+	}
+
+	if (VisualsActor == nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		VisualsActor = World->SpawnActor<AActor>(SpawnParams);
+	}
+
+	auto CreateInstances = [this](const UStaticMeshComponent* Template) -> UInstancedStaticMeshComponent*
+	{
+		UInstancedStaticMeshComponent* Instances = NewObject<UInstancedStaticMeshComponent>(VisualsActor);
+		Instances->SetStaticMesh(Template->GetStaticMesh());
+		for (int32 i = 0; i < Template->GetNumMaterials(); ++i)
+		{
+			Instances->SetMaterial(i, Template->GetMaterial(i));
+		}
+		Instances->SetMobility(EComponentMobility::Movable);
+		Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Instances->SetGenerateOverlapEvents(false);
+		Instances->SetCanEverAffectNavigation(false);
+		Instances->RegisterComponent();
+		VisualsActor->AddInstanceComponent(Instances);
+		return Instances;
+	};
+
+	Group.BaseInstances = CreateInstances(BaseMesh);
+	Group.YawInstances = CreateInstances(YawMesh);
+	Group.PitchInstances = bSeparatePitch ? CreateInstances(PitchMesh) : nullptr;
+
+	return &Group;
+}
+
+void UTurretProxySubsystem::LoadGroupAssets(int32 GroupIndex)
+{
+	const ATurret* Defaults = Groups[GroupIndex].TurretClass->GetDefaultObject<ATurret>();
+	if (Defaults->Archetype.IsNull())
+	{
+		LoadGroupClassAssets(GroupIndex);
+		return;
+	}
+
+	// Same bundle as the turret actors of the class load
+	UAssetManager& AssetManager = UAssetManager::Get();
+	const FPrimaryAssetId ArchetypeId = AssetManager.GetPrimaryAssetIdForPath(Defaults->Archetype.ToSoftObjectPath());
+	if (ArchetypeId.IsValid() == false)
+	{
+		LoadGroupClassAssets(GroupIndex);
+		return;
+	}
+
+	const TSharedPtr<FStreamableHandle> Handle = AssetManager.LoadPrimaryAsset(ArchetypeId, { UTurretArchetype::GameBundle },
+		FStreamableDelegate::CreateUObject(this, &UTurretProxySubsystem::OnGroupArchetypeLoaded, GroupIndex));
+	if (Handle.IsValid() == false || Handle->HasLoadCompleted())
+	{
+		OnGroupArchetypeLoaded(GroupIndex);
+	}
+}
+
+void UTurretProxySubsystem::LoadGroupClassAssets(int32 GroupIndex)
+{
+	const ATurret* Defaults = Groups[GroupIndex].TurretClass->GetDefaultObject<ATurret>();
+
+	TArray<FSoftObjectPath> Paths;
+	Defaults->GetClassAssetPaths(Paths);
+
+	// Shared with the turret actors of the class, so whichever comes first starts loading
+	const UGameInstance* GameInstance = GetWorld()->GetGameInstance();
+	UTurretAssetSubsystem* AssetSubsystem = GameInstance ? GameInstance->GetSubsystem<UTurretAssetSubsystem>() : nullptr;
+	if (AssetSubsystem == nullptr || AssetSubsystem->RequestClassAssets(Defaults->GetClass(), Paths,
+		FStreamableDelegate::CreateUObject(this, &UTurretProxySubsystem::ResolveGroupAssets, GroupIndex)))
+	{
+		ResolveGroupAssets(GroupIndex);
+	}
+}
+
+void UTurretProxySubsystem::OnGroupArchetypeLoaded(int32 GroupIndex)
+{
+	// The groups are emptied when the world is torn down during the load
+	if (Groups.IsValidIndex(GroupIndex) == false || Groups[GroupIndex].bAssetsLoaded)
+	{
+		return;
+	}
+
+	if (Groups[GroupIndex].TurretClass->GetDefaultObject<ATurret>()->Archetype.Get() == nullptr)
+	{
+		LoadGroupClassAssets(GroupIndex);
+		return;
+	}
+
+	ResolveGroupAssets(GroupIndex);
+}
+
+void UTurretProxySubsystem::ResolveGroupAssets(int32 GroupIndex)
+{
+	if (Groups.IsValidIndex(GroupIndex) == false || Groups[GroupIndex].bAssetsLoaded)
+	{
+		return;
+	}
+
+	FTurretProxyGroup& Group = Groups[GroupIndex];
+	const ATurret* Defaults = Group.TurretClass->GetDefaultObject<ATurret>();
+	if (const UTurretArchetype* Archetype = Defaults->Archetype.Get())
+	{
+		Group.TurretInfo = Archetype->TurretInfo;
+		Group.ProjectileClass = Archetype->Projectile.Get();
+	}
+	else
+	{
+		Group.TurretInfo = Defaults->TurretInfo;
+		Group.ProjectileClass = Defaults->Projectile.Get();
+	}
+
+	Group.bAssetsLoaded = true;
+}
+
+void UTurretProxySubsystem::Tick(float DeltaTime)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_ProxyTick);
+	TURRETAI_PROFILE_SCOPE(Tick);
+
+	Super::Tick(DeltaTime);
+
+	const bool bHasAuthority = GetWorld()->GetNetMode() != NM_Client;
+
+	PromotionTime += DeltaTime;
+	const bool bUpdatePromotions = PromotionTime >= PromotionInterval;
+
+	// Only the server promotes by distance, where every player counts
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	if (bUpdatePromotions)
+	{
+		PromotionTime = 0.0f;
+
+		for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+		{
+			if (const APlayerController* PlayerController = It->Get())
+			{
+				FVector ViewLocation;
+				FRotator ViewRotation;
+				PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+				ViewLocations.Add(ViewLocation);
+			}
+		}
+	}
+
+	for (FTurretProxyGroup& Group : Groups)
+	{
+		// The proxies are drawn while the assets of their class are loading, but not simulated
+		if (Group.bAssetsLoaded)
+		{
+			if (bHasAuthority)
+			{
+				UpdateTargets(Group);
+			}
+
+			// Clients turn the proxies toward the targets that the server has sent
+			UpdateRotations(Group, DeltaTime);
+
+			if (bHasAuthority)
+			{
+				FireProxies(Group, DeltaTime);
+			}
+		}
+
+		if (bUpdatePromotions)
+		{
+			UpdatePromotions(Group, ViewLocations);
+		}
+
+		UpdateInstances(Group);
+	}
+
+	SET_DWORD_STAT(STAT_TurretAI_Proxies, GetNumProxies());
+
+	++FrameCounter;
+}
+
+void UTurretProxySubsystem::UpdateTargets(FTurretProxyGroup& Group) const
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_ProxyTargets);
+
+	const UTurretTargetSubsystem* TargetSubsystem = GetWorld()->GetSubsystem<UTurretTargetSubsystem>();
+	if (TargetSubsystem == nullptr)
+	{
+		return;
+	}
+
+	const int32 Num = Group.Num();
+	const int32 Interval = FMath::Max(TargetingFrameInterval, 1);
+	const int32 NumPerChunk = FMath::Max(ChunkSize, 1);
+
+	// The grid of the target subsystem is only rebuilt on the game thread, so it is a read-only snapshot here
+	ParallelFor(FMath::DivideAndRoundUp(Num, NumPerChunk), [&Group, TargetSubsystem, Num, Interval, NumPerChunk, this](int32 ChunkIndex)
+	{
+		const int32 End = FMath::Min((ChunkIndex + 1) * NumPerChunk, Num);
+		for (int32 i = ChunkIndex * NumPerChunk; i < End; ++i)
+		{
+			// Promoted proxies are handled by their turret actor
+			if (Group.Promoted[i] || (FrameCounter + i) % Interval != 0)
+			{
+				continue;
+			}
+
+			FVector TargetLocation;
+			AActor* NewTarget = TargetSubsystem->FindClosestTarget(Group.Transforms[i].GetLocation(), Group.DetectionRadius, TargetLocation);
+			Group.AimChanged[i] |= Group.Targets[i] != NewTarget;
+			Group.Targets[i] = NewTarget;
+			Group.TargetLocations[i] = TargetLocation;
+		}
+	});
+
+	// Only the target changes are sent, like the aim state of the turret actors
+	if (AimStream)
+	{
+		for (int32 i = 0; i < Num; ++i)
+		{
+			if (Group.AimChanged[i])
+			{
+				Group.AimChanged[i] = 0;
+				SendProxyAim(Group, i);
+			}
+		}
+	}
+}
+
+void UTurretProxySubsystem::UpdateRotations(FTurretProxyGroup& Group, float DeltaTime) const
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_ProxyRotations);
+
+	const int32 Num = Group.Num();
+	const int32 NumPerChunk = FMath::Max(ChunkSize, 1);
+	const float Step = FMath::Min(Group.TurretInfo.RotationSpeed * DeltaTime, 180.0f);
+
+	ParallelFor(FMath::DivideAndRoundUp(Num, NumPerChunk), [&Group, Num, NumPerChunk, Step](int32 ChunkIndex)
+	{
+		const int32 End = FMath::Min((ChunkIndex + 1) * NumPerChunk, Num);
+		for (int32 i = ChunkIndex * NumPerChunk; i < End; ++i)
+		{
+			// The game thread waits for the tasks, so the targets can't move or be destroyed meanwhile
+			const AActor* Target = Group.Promoted[i] ? nullptr : Group.Targets[i].Get();
+			if (Target == nullptr)
+			{
+				continue;
+			}
+
+			Group.TargetLocations[i] = Target->GetActorLocation();
+
+			const FVector Pivot = Group.Transforms[i].TransformPosition(Group.PivotOffset);
+			const FRotator TargetRotation = Group.InvRotations[i].RotateVector(Group.TargetLocations[i] - Pivot).Rotation();
+
+			const float DeltaYaw = FRotator::NormalizeAxis(TargetRotation.Yaw - Group.Yaws[i]);
+			const float NewYaw = FRotator::NormalizeAxis(Group.Yaws[i] + FMath::Clamp(DeltaYaw, -Step, Step));
+
+			const float DeltaPitch = FRotator::NormalizeAxis(TargetRotation.Pitch - Group.Pitches[i]);
+			const float NewPitch = FMath::ClampAngle(Group.Pitches[i] + FMath::Clamp(DeltaPitch, -Step, Step), Group.TurretInfo.MinPitch, Group.TurretInfo.MaxPitch);
+
+			// Proxies that are aimed at their target are not uploaded again
+			if (NewYaw != Group.Yaws[i] || NewPitch != Group.Pitches[i])
+			{
+				Group.Yaws[i] = NewYaw;
+				Group.Pitches[i] = NewPitch;
+				Group.DirtyInstances[i] |= RotationDirtyFlag;
+			}
+		}
+	});
+}
+
+void UTurretProxySubsystem::FireProxies(FTurretProxyGroup& Group, float DeltaTime) const
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_ProxyFire);
+
+	UProjectileSimulationSubsystem* ProjectileSimulation = GetWorld()->GetSubsystem<UProjectileSimulationSubsystem>();
+	if (ProjectileSimulation == nullptr || Group.ProjectileClass == nullptr)
+	{
+		return;
+	}
+
+	const bool bHoming = Group.TurretInfo.HasFlag(ETurretAbility::Homing);
+	const bool bExplosive = Group.TurretInfo.HasFlag(ETurretAbility::ExplosiveShot);
+
+	for (int32 i = 0; i < Group.Num(); ++i)
+	{
+		Group.Cooldowns[i] = FMath::Max(Group.Cooldowns[i] - DeltaTime, 0.0f);
+
+		AActor* Target = Group.Promoted[i] ? nullptr : Group.Targets[i].Get();
+		if (Target == nullptr || Group.Cooldowns[i] > 0.0f)
+		{
+			continue;
+		}
+
+		// Far from the players, so the can hit target sweep of the turret actors is skipped
+		const FTransform PitchTransform = GetPitchTransform(Group, i);
+		const FVector Direction = (Group.TargetLocations[i] - PitchTransform.GetLocation()).GetSafeNormal();
+		if (FVector::DotProduct(PitchTransform.GetUnitAxis(EAxis::X), Direction) < FMath::Cos(FMath::DegreesToRadians(AimTolerance)))
+		{
+			continue;
+		}
+
+		Group.Cooldowns[i] = Group.TurretInfo.FireRate;
+
+		ProjectileSimulation->FireProjectile(Group.ProjectileClass, Group.MuzzleSocket * PitchTransform, nullptr, nullptr,
+			bHoming ? Target->GetRootComponent() : nullptr, bExplosive);
+	}
+}
+
+void UTurretProxySubsystem::UpdatePromotions(FTurretProxyGroup& Group, const TArray<FVector, TInlineAllocator<4>>& ViewLocations)
+{
+	const bool bHasAuthority = GetWorld()->GetNetMode() != NM_Client;
+	const float PromoteDistanceSquared = FMath::Square(PromoteDistance);
+	const float DemoteDistanceSquared = FMath::Square(FMath::Max(DemoteDistance, PromoteDistance));
+
+	for (int32 i = Group.Num() - 1; i >= 0; --i)
+	{
+		// Clients only hide the proxies while the turret actor that the server has promoted them to is relevant,
+		// the server keeps turrets with a target promoted, so the distance alone would draw them twice
+		if (bHasAuthority == false)
+		{
+			const uint8 bPromoted = Group.Actors[i].IsValid();
+			Group.DirtyInstances[i] |= Group.Promoted[i] != bPromoted ? RotationDirtyFlag | BaseDirtyFlag : 0;
+			Group.Promoted[i] = bPromoted;
+			continue;
+		}
+
+		float DistanceSquared = MAX_flt;
+		for (const FVector& ViewLocation : ViewLocations)
+		{
+			DistanceSquared = FMath::Min(DistanceSquared, static_cast<float>(FVector::DistSquared(ViewLocation, Group.Transforms[i].GetLocation())));
+		}
+
+		if (Group.Promoted[i] == 0)
+		{
+			if (DistanceSquared <= PromoteDistanceSquared)
+			{
+				Promote(Group, i);
+			}
+
+			continue;
+		}
+
+		const ATurret* Turret = Group.Actors[i].Get();
+		if (IsValid(Turret) == false)
+		{
+			// Destroyed by the gameplay, the proxy is gone with it
+			RemoveProxyAt(Group, i);
+		}
+		else if (DistanceSquared > DemoteDistanceSquared && Turret->GetCurrentTarget() == nullptr)
+		{
+			Demote(Group, i);
+		}
+	}
+}
+
+void UTurretProxySubsystem::Promote(FTurretProxyGroup& Group, int32 Index) const
+{
+	const FTransform& Transform = Group.Transforms[Index];
+
+	ATurret* Turret = GetWorld()->SpawnActorDeferred<ATurret>(Group.TurretClass, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (Turret == nullptr)
+	{
+		return;
+	}
+
+	// The turret manager reads the rotation of the parts when the turret begins play
+	if (Group.bSeparatePitch)
+	{
+		Turret->GetYawComponent()->SetRelativeRotation(FRotator(0.0f, Group.Yaws[Index], 0.0f));
+		Turret->GetPitchComponent()->SetRelativeRotation(FRotator(Group.Pitches[Index], 0.0f, 0.0f));
+	}
+	else
+	{
+		Turret->GetPitchComponent()->SetRelativeRotation(FRotator(Group.Pitches[Index], Group.Yaws[Index], 0.0f));
+	}
+
+	Turret->FinishSpawning(Transform);
+
+	Group.Actors[Index] = Turret;
+	Group.Promoted[Index] = 1;
+	Group.Targets[Index].Reset();
+	Group.DirtyInstances[Index] |= RotationDirtyFlag | BaseDirtyFlag;
+
+	SendProxyAim(Group, Index);
+}
+
+void UTurretProxySubsystem::Demote(FTurretProxyGroup& Group, int32 Index) const
+{
+	ATurret* Turret = Group.Actors[Index].Get();
+
+	Group.Yaws[Index] = Turret->GetYawComponent()->GetRelativeRotation().Yaw;
+	Group.Pitches[Index] = Turret->GetPitchComponent()->GetRelativeRotation().Pitch;
+
+	// Replaced by the proxy, so no debris or effects
+	Turret->DemoteToProxy();
+
+	Group.Actors[Index].Reset();
+	Group.Promoted[Index] = 0;
+	Group.DirtyInstances[Index] |= RotationDirtyFlag | BaseDirtyFlag;
+
+	// The proxy continues from the rotation of the turret actor
+	SendProxyAim(Group, Index);
+}
+
+void UTurretProxySubsystem::SendProxyAim(const FTurretProxyGroup& Group, int32 Index) const
+{
+	if (AimStream == nullptr || Group.AimIndices[Index] == INDEX_NONE)
+	{
+		return;
+	}
+
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+
+	FTurretAimState AimState;
+	AimState.Target = Group.Targets[Index].Get();
+	AimState.bHasTarget = AimState.Target != nullptr;
+	AimState.SetRotation(Group.Yaws[Index], Group.Pitches[Index]);
+	AimState.ServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+
+	AimStream->SetAim(Group.AimIndices[Index], AimState, Group.Actors[Index].Get());
+}
+
+void UTurretProxySubsystem::RemoveProxyAim(int32 AimIndex)
+{
+	if (AimStream == nullptr || AimIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	// The last aim is moved to the removed index, so its proxy is pointed to the new index
+	const int32 LastIndex = AimStream->GetNumAims() - 1;
+	if (AimIndex != LastIndex)
+	{
+		const int32 MovedId = AimStream->GetAim(LastIndex).ProxyId;
+		FTurretProxyGroup& MovedGroup = Groups[ProxyGroupIndices[MovedId]];
+		MovedGroup.AimIndices[MovedGroup.IdIndices[MovedId]] = AimIndex;
+	}
+
+	AimStream->RemoveAim(AimIndex);
+}
+
+FTransform UTurretProxySubsystem::GetYawTransform(const FTurretProxyGroup& Group, int32 Index)
+{
+	const FTransform BaseTransform = Group.BaseTransform * Group.Transforms[Index];
+	const FRotator Rotation(Group.bSeparatePitch ? 0.0f : Group.Pitches[Index], Group.Yaws[Index], 0.0f);
+	return FTransform(Rotation, Group.YawTransform.GetLocation(), Group.YawTransform.GetScale3D()) * Group.YawSocket * BaseTransform;
+}
+
+FTransform UTurretProxySubsystem::GetPitchTransform(const FTurretProxyGroup& Group, int32 Index)
+{
+	const FTransform YawTransform = GetYawTransform(Group, Index);
+	if (Group.bSeparatePitch == false)
+	{
+		return YawTransform;
+	}
+
+	const FRotator Rotation(Group.Pitches[Index], 0.0f, 0.0f);
+	return FTransform(Rotation, Group.PitchTransform.GetLocation(), Group.PitchTransform.GetScale3D()) * Group.PitchSocket * YawTransform;
+}
+
+void UTurretProxySubsystem::UpdateInstances(FTurretProxyGroup& Group)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_ProxyInstances);
+
+	if (Group.BaseInstances == nullptr)
+	{
+		return;
+	}
+
+	const int32 Num = Group.Num();
+
+	// Promoted proxies are drawn by their turret actor
+	const FTransform HiddenTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+
+	// Adding or removing proxies moves other proxies to new instances, so all instances are rebuilt
+	if (Group.BaseInstances->GetInstanceCount() != Num)
+	{
+		TArray<FTransform> BaseTransforms, YawTransforms, PitchTransforms;
+		BaseTransforms.SetNumUninitialized(Num);
+		YawTransforms.SetNumUninitialized(Num);
+		PitchTransforms.SetNumUninitialized(Group.bSeparatePitch ? Num : 0);
+
+		for (int32 i = 0; i < Num; ++i)
+		{
+			const bool bHidden = Group.Promoted[i] != 0;
+			BaseTransforms[i] = bHidden ? HiddenTransform : Group.BaseTransform * Group.Transforms[i];
+			YawTransforms[i] = bHidden ? HiddenTransform : GetYawTransform(Group, i);
+			if (Group.bSeparatePitch)
+			{
+				PitchTransforms[i] = bHidden ? HiddenTransform : GetPitchTransform(Group, i);
+			}
+		}
+
+		auto ResetInstances = [](UInstancedStaticMeshComponent* Instances, const TArray<FTransform>& Transforms)
+		{
+			Instances->ClearInstances();
+			Instances->AddInstances(Transforms, false, true);
+		};
+
+		ResetInstances(Group.BaseInstances, BaseTransforms);
+		ResetInstances(Group.YawInstances, YawTransforms);
+		if (Group.PitchInstances)
+		{
+			ResetInstances(Group.PitchInstances, PitchTransforms);
+		}
+
+		FMemory::Memzero(Group.DirtyInstances.GetData(), Num);
+		return;
+	}
+
+	// Only the changed instances are sent to the render thread, the render state is marked dirty once per component
+	bool bRotationsChanged = false;
+	bool bBasesChanged = false;
+
+	for (int32 i = 0; i < Num; ++i)
+	{
+		const uint8 Dirty = Group.DirtyInstances[i];
+		if (Dirty == 0)
+		{
+			continue;
+		}
+
+		Group.DirtyInstances[i] = 0;
+		const bool bHidden = Group.Promoted[i] != 0;
+
+		if (Dirty & RotationDirtyFlag)
+		{
+			Group.YawInstances->UpdateInstanceTransform(i, bHidden ? HiddenTransform : GetYawTransform(Group, i), true, false, true);
+			if (Group.PitchInstances)
+			{
+				Group.PitchInstances->UpdateInstanceTransform(i, bHidden ? HiddenTransform : GetPitchTransform(Group, i), true, false, true);
+			}
+
+			bRotationsChanged = true;
+		}
+
+		if (Dirty & BaseDirtyFlag)
+		{
+			Group.BaseInstances->UpdateInstanceTransform(i, bHidden ? HiddenTransform : Group.BaseTransform * Group.Transforms[i], true, false, true);
+			bBasesChanged = true;
+		}
+	}
+
+	if (bRotationsChanged)
+	{
+		Group.YawInstances->MarkRenderStateDirty();
+		if (Group.PitchInstances)
+		{
+			Group.PitchInstances->MarkRenderStateDirty();
+		}
+	}
+
+	if (bBasesChanged)
+	{
+		Group.BaseInstances->MarkRenderStateDirty();
+	}
+}
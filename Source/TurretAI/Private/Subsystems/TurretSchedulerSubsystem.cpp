@@ -0,0 +1,215 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/TurretSchedulerSubsystem.h"
+
+#include "Actors/Turret.h"
+#include "Async/ParallelFor.h"
+#include "TurretAIProfiling.h"
+
+DECLARE_CYCLE_STAT(TEXT("Turret Scheduler Tick"), STAT_TurretAI_SchedulerTick, STATGROUP_TurretAI);
+
+void UTurretSchedulerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	SlotDuration = FMath::Max(SlotDuration, UE_KINDA_SMALL_NUMBER);
+	NumSlots = FMath::Max(NumSlots, 1);
+	Slots.SetNum(NumSlots);
+}
+
+void UTurretSchedulerSubsystem::Deinitialize()
+{
+	Slots.Empty();
+	SearchBatch.Empty();
+
+	for (TArray<FScheduledTask>& Tasks : ReadyTasks)
+	{
+		Tasks.Empty();
+	}
+
+	FMemory::Memzero(ReadyHeads);
+
+	Super::Deinitialize();
+}
+
+bool UTurretSchedulerSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UTurretSchedulerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTurretSchedulerSubsystem, STATGROUP_Tickables);
+}
+
+void UTurretSchedulerSubsystem::Schedule(ATurret* Turret, ETurretTask Task, float Delay)
+{
+	const int32 TaskIndex = static_cast<int32>(Task);
+
+	FScheduledTask ScheduledTask;
+	ScheduledTask.Turret = Turret;
+	ScheduledTask.Sequence = ++Turret->TaskSequences[TaskIndex];
+	ScheduledTask.Task = Task;
+
+	Turret->ScheduledTasks |= 1 << TaskIndex;
+
+	if (Delay <= 0.0f)
+	{
+		ReadyTasks[TaskIndex].Add(ScheduledTask);
+		return;
+	}
+
+	// Slot k expires after (k * SlotDuration - SlotTime) seconds
+	const int32 NumTicks = FMath::Max(1, FMath::CeilToInt32((Delay + SlotTime) / SlotDuration));
+	ScheduledTask.Rounds = (NumTicks - 1) / NumSlots;
+
+	Slots[(CurrentSlot + NumTicks) % NumSlots].Add(ScheduledTask);
+}
+
+void UTurretSchedulerSubsystem::Cancel(ATurret* Turret, ETurretTask Task)
+{
+	const int32 TaskIndex = static_cast<int32>(Task);
+
+	// The pending task is skipped because its sequence doesn't match anymore
+	++Turret->TaskSequences[TaskIndex];
+	Turret->ScheduledTasks &= ~(1 << TaskIndex);
+}
+
+bool UTurretSchedulerSubsystem::IsScheduled(const ATurret* Turret, ETurretTask Task)
+{
+	return (Turret->ScheduledTasks & (1 << static_cast<int32>(Task))) != 0;
+}
+
+bool UTurretSchedulerSubsystem::IsValidTask(const FScheduledTask& ScheduledTask)
+{
+	const ATurret* Turret = ScheduledTask.Turret.Get();
+	return IsValid(Turret) && Turret->TaskSequences[static_cast<int32>(ScheduledTask.Task)] == ScheduledTask.Sequence;
+}
+
+void UTurretSchedulerSubsystem::Tick(float DeltaTime)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_SchedulerTick);
+	TURRETAI_PROFILE_SCOPE(Tick);
+
+	Super::Tick(DeltaTime);
+
+	SlotTime += DeltaTime;
+	while (SlotTime >= SlotDuration)
+	{
+		SlotTime -= SlotDuration;
+		CurrentSlot = (CurrentSlot + 1) % NumSlots;
+		ExpireSlot(CurrentSlot);
+	}
+
+	RunReadyTasks(ETurretTask::Search, MaxSearchesPerFrame);
+	RunReadyTasks(ETurretTask::Fire, MaxFireChecksPerFrame);
+	RunReadyTasks(ETurretTask::RandomRotation, MAX_int32);
+}
+
+void UTurretSchedulerSubsystem::ExpireSlot(int32 SlotIndex)
+{
+	TArray<FScheduledTask>& Slot = Slots[SlotIndex];
+
+	// Compacting in place keeps the tasks that stay in the slot in the order they were scheduled
+	int32 WriteIndex = 0;
+	for (int32 i = 0; i < Slot.Num(); ++i)
+	{
+		FScheduledTask& ScheduledTask = Slot[i];
+		if (IsValidTask(ScheduledTask) == false)
+		{
+			continue;
+		}
+
+		if (ScheduledTask.Rounds > 0)
+		{
+			--ScheduledTask.Rounds;
+			if (WriteIndex != i)
+			{
+				Slot[WriteIndex] = ScheduledTask;
+			}
+			++WriteIndex;
+		}
+		else
+		{
+			ReadyTasks[static_cast<int32>(ScheduledTask.Task)].Add(ScheduledTask);
+		}
+	}
+
+	Slot.SetNum(WriteIndex, false);
+}
+
+void UTurretSchedulerSubsystem::RunReadyTasks(ETurretTask Task, int32 Budget)
+{
+	TArray<FScheduledTask>& Tasks = ReadyTasks[static_cast<int32>(Task)];
+	int32& Head = ReadyHeads[static_cast<int32>(Task)];
+
+	// Tasks that are added while running are left for the next frame
+	const int32 NumTasks = Tasks.Num();
+
+	int32 NumRun = 0;
+	while (Head < NumTasks && NumRun < Budget)
+	{
+		const FScheduledTask ScheduledTask = Tasks[Head++];
+		if (IsValidTask(ScheduledTask) == false)
+		{
+			continue;
+		}
+
+		ATurret* Turret = ScheduledTask.Turret.Get();
+		Turret->ScheduledTasks &= ~(1 << static_cast<int32>(Task));
+		++NumRun;
+
+		switch (Task)
+		{
+		case ETurretTask::Search:
+			// Ranked together after the loop
+			if (Turret->GatherTargetCandidates())
+			{
+				SearchBatch.Add(Turret);
+			}
+			break;
+		case ETurretTask::Fire:
+			Turret->FireTurret();
+			break;
+		case ETurretTask::RandomRotation:
+			Turret->FindRandomRotation();
+			break;
+		default:
+			break;
+		}
+	}
+
+	// The processed tasks are only dropped when the queue is empty or mostly processed, so the queue isn't shifted every frame
+	if (Head == Tasks.Num())
+	{
+		Tasks.Reset();
+		Head = 0;
+	}
+	else if (Head > Tasks.Num() / 2)
+	{
+		Tasks.RemoveAt(0, Head, false);
+		Head = 0;
+	}
+
+	if (Task == ETurretTask::Search)
+	{
+		RunSearchBatch();
+	}
+}
+
+void UTurretSchedulerSubsystem::RunSearchBatch()
+{
+	// Ranking only reads the snapshots of each turret, so the searches of the frame are ranked in parallel
+	ParallelFor(SearchBatch.Num(), [this](int32 Index)
+	{
+		SearchBatch[Index]->RankTargets();
+	}, SearchBatch.Num() < MinParallelSearches ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	// Traces are started on the game thread in the same order as the searches
+	for (ATurret* Turret : SearchBatch)
+	{
+		Turret->RequestCanSeeTargets(Turret->TargetCandidates);
+	}
+
+	SearchBatch.Reset();
+}
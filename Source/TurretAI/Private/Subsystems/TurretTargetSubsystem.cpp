@@ -0,0 +1,268 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Subsystems/TurretTargetSubsystem.h"
+
+#include "Actors/Turret.h"
+#include "Components/SphereComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "TurretAIProfiling.h"
+
+DECLARE_CYCLE_STAT(TEXT("Turret Target Tick"), STAT_TurretAI_TargetTick, STATGROUP_TurretAI);
+
+void UTurretTargetSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	for (TActorIterator<APawn> It(&InWorld); It; ++It)
+	{
+		Candidates.Add(*It);
+	}
+
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UTurretTargetSubsystem::OnActorSpawned));
+}
+
+void UTurretTargetSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+
+	Candidates.Empty();
+	CandidateActors.Empty();
+	CandidateLocations.Empty();
+	CandidateRadii.Empty();
+	Grid.Empty();
+	Turrets.Empty();
+	TurretCenters.Empty();
+	TurretRadii.Empty();
+	LastCandidates.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTurretTargetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UTurretTargetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTurretTargetSubsystem, STATGROUP_Tickables);
+}
+
+void UTurretTargetSubsystem::OnActorSpawned(AActor* Actor)
+{
+	if (APawn* Pawn = Cast<APawn>(Actor))
+	{
+		Candidates.Add(Pawn);
+	}
+}
+
+void UTurretTargetSubsystem::RegisterTurret(ATurret* Turret)
+{
+	if (Turret == nullptr || Turrets.Contains(Turret))
+	{
+		return;
+	}
+
+	Turrets.Add(Turret);
+	TurretCenters.Add(Turret->Detector->GetComponentLocation());
+	TurretRadii.Add(Turret->Detector->GetScaledSphereRadius());
+	LastCandidates.AddDefaulted();
+}
+
+void UTurretTargetSubsystem::UnregisterTurret(ATurret* Turret)
+{
+	const int32 Index = Turrets.Find(Turret);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	Turrets.RemoveAtSwap(Index, 1, false);
+	TurretCenters.RemoveAtSwap(Index, 1, false);
+	TurretRadii.RemoveAtSwap(Index, 1, false);
+	LastCandidates.RemoveAtSwap(Index, 1, false);
+}
+
+void UTurretTargetSubsystem::Tick(float DeltaTime)
+{
+	TURRETAI_SCOPE_CYCLE_COUNTER(STAT_TurretAI_TargetTick);
+	TURRETAI_PROFILE_SCOPE(Targeting);
+
+	Super::Tick(DeltaTime);
+
+	// Targets are only searched on the server, and only by the turrets that use the spatial index and by the grid users
+	if ((Turrets.IsEmpty() && NumGridUsers == 0) || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	RebuildGrid();
+	UpdateTurrets();
+}
+
+FIntPoint UTurretTargetSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+void UTurretTargetSubsystem::RebuildGrid()
+{
+	// Keep the cell allocations between frames, only drop them when the grid gets too sparse
+	if (Grid.Num() > FMath::Max(64, CandidateActors.Num() * 4))
+	{
+		Grid.Reset();
+	}
+	else
+	{
+		for (TPair<FIntPoint, TArray<int32>>& Cell : Grid)
+		{
+			Cell.Value.Reset();
+		}
+	}
+
+	CandidateActors.Reset();
+	CandidateLocations.Reset();
+	CandidateRadii.Reset();
+
+	for (int32 i = Candidates.Num() - 1; i >= 0; --i)
+	{
+		APawn* Pawn = Candidates[i].Get();
+		if (IsValid(Pawn) == false)
+		{
+			Candidates.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+
+		const FVector Location = Pawn->GetActorLocation();
+		const int32 Index = CandidateActors.Add(Pawn);
+		CandidateLocations.Add(Location);
+		CandidateRadii.Add(Pawn->GetSimpleCollisionRadius());
+
+		Grid.FindOrAdd(GetCell(Location)).Add(Index);
+	}
+}
+
+template<typename FunctionType>
+void UTurretTargetSubsystem::ForEachCandidateInRange(const FVector& Center, float Radius, FunctionType Function) const
+{
+	// Candidates are bucketed by their location, so the search is extended by the largest possible collision radius
+	const FIntPoint MinCell = GetCell(Center - FVector(Radius + CellSize));
+	const FIntPoint MaxCell = GetCell(Center + FVector(Radius + CellSize));
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			const TArray<int32>* Cell = Grid.Find(FIntPoint(X, Y));
+			if (Cell == nullptr)
+			{
+				continue;
+			}
+
+			for (const int32 Index : *Cell)
+			{
+				const float Range = Radius + CandidateRadii[Index];
+				if (FVector::DistSquared(Center, CandidateLocations[Index]) <= Range * Range)
+				{
+					Function(Index);
+				}
+			}
+		}
+	}
+}
+
+int32 UTurretTargetSubsystem::QueryTargets(const FVector& Center, float Radius, TArray<AActor*>& OutTargets) const
+{
+	const int32 StartNum = OutTargets.Num();
+
+	ForEachCandidateInRange(Center, Radius, [this, &OutTargets](const int32 Index)
+	{
+		AActor* Candidate = CandidateActors[Index];
+		if (IsValid(Candidate))
+		{
+			OutTargets.Add(Candidate);
+		}
+	});
+
+	return OutTargets.Num() - StartNum;
+}
+
+AActor* UTurretTargetSubsystem::FindClosestTarget(const FVector& Center, float Radius, FVector& OutLocation) const
+{
+	int32 ClosestIndex = INDEX_NONE;
+	float ClosestDistanceSquared = MAX_flt;
+
+	ForEachCandidateInRange(Center, Radius, [this, &Center, &ClosestIndex, &ClosestDistanceSquared](const int32 Index)
+	{
+		const float DistanceSquared = FVector::DistSquared(Center, CandidateLocations[Index]);
+		if (DistanceSquared < ClosestDistanceSquared)
+		{
+			ClosestIndex = Index;
+			ClosestDistanceSquared = DistanceSquared;
+		}
+	});
+
+	if (ClosestIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	OutLocation = CandidateLocations[ClosestIndex];
+	return CandidateActors[ClosestIndex];
+}
+
+bool UTurretTargetSubsystem::IsInRange(const AActor* Target, const FVector& Center, float Radius)
+{
+	if (IsValid(Target) == false)
+	{
+		return false;
+	}
+
+	const float Range = Radius + Target->GetSimpleCollisionRadius();
+	return FVector::DistSquared(Center, Target->GetActorLocation()) <= Range * Range;
+}
+
+void UTurretTargetSubsystem::UpdateTurrets()
+{
+	for (int32 i = 0; i < Turrets.Num(); ++i)
+	{
+		ATurret* Turret = Turrets[i];
+
+		if (const AActor* Target = Turret->GetCurrentTarget())
+		{
+			// Same as the end overlap event of the detector
+			if (IsInRange(Target, TurretCenters[i], TurretRadii[i]) == false)
+			{
+				Turret->FindNewTarget();
+			}
+
+			continue;
+		}
+
+		TArray<FObjectKey, TInlineAllocator<16>> InRange;
+		ForEachCandidateInRange(TurretCenters[i], TurretRadii[i], [this, &InRange](const int32 Index)
+		{
+			InRange.Add(FObjectKey(CandidateActors[Index]));
+		});
+
+		// Same as the begin overlap event of the detector, only react when a candidate that was not in range has entered it
+		TArray<FObjectKey>& Last = LastCandidates[i];
+		const bool bNewCandidate = InRange.ContainsByPredicate([&Last](const FObjectKey& Candidate)
+		{
+			return Last.Contains(Candidate) == false;
+		});
+
+		Last.Reset();
+		Last.Append(InRange);
+
+		if (bNewCandidate)
+		{
+			Turret->FindNewTarget();
+		}
+	}
+}
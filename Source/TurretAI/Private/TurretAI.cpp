@@ -2,11 +2,22 @@
 
 #include "TurretAI.h"
 
+#include "Engine/AssetManager.h"
+#include "Types/TurretArchetype.h"
+
 #define LOCTEXT_NAMESPACE "FTurretAIModule"
 
+DEFINE_LOG_CATEGORY(LogTurretAI);
+
 void FTurretAIModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+
+	// Turrets load their archetypes through the asset manager
+	UAssetManager::CallOrRegister_OnAssetManagerCreated(FSimpleMulticastDelegate::FDelegate::CreateLambda([]()
+	{
+		UAssetManager::Get().ScanPathForPrimaryAssets(UTurretArchetype::PrimaryAssetType, TEXT("/TurretAI"), UTurretArchetype::StaticClass(), false);
+	}));
 }
 
 void FTurretAIModule::ShutdownModule()
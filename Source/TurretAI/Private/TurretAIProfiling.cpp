@@ -0,0 +1,63 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "TurretAIProfiling.h"
+
+DEFINE_STAT(STAT_TurretAI_ActiveTurrets);
+DEFINE_STAT(STAT_TurretAI_LiveProjectiles);
+DEFINE_STAT(STAT_TurretAI_Traces);
+DEFINE_STAT(STAT_TurretAI_FireEvents);
+
+TRACE_DECLARE_INT_COUNTER(TurretAI_ActiveTurrets, TEXT("TurretAI/ActiveTurrets"));
+TRACE_DECLARE_INT_COUNTER(TurretAI_LiveProjectiles, TEXT("TurretAI/LiveProjectiles"));
+TRACE_DECLARE_INT_COUNTER(TurretAI_Traces, TEXT("TurretAI/Traces"));
+TRACE_DECLARE_INT_COUNTER(TurretAI_FireEvents, TEXT("TurretAI/FireEvents"));
+
+UE_TRACE_CHANNEL_DEFINE(TurretAIChannel);
+
+int32 FTurretStats::NumTraces = 0;
+int32 FTurretStats::NumFireEvents = 0;
+
+bool FTurretProfiler::bEnabled = false;
+uint64 FTurretProfiler::Cycles[static_cast<int32>(ETurretProfileCategory::Num)] = {};
+FTurretProfileScope* FTurretProfileScope::Current = nullptr;
+
+void FTurretProfileScope::Begin()
+{
+	StartCycles = FPlatformTime::Cycles();
+	bActive = true;
+
+	// Pause the parent until this scope ends
+	Parent = Current;
+	if (Parent)
+	{
+		FTurretProfiler::Cycles[static_cast<int32>(Parent->Category)] += StartCycles - Parent->StartCycles;
+	}
+
+	Current = this;
+}
+
+void FTurretProfileScope::End()
+{
+	const uint32 EndCycles = FPlatformTime::Cycles();
+	FTurretProfiler::Cycles[static_cast<int32>(Category)] += EndCycles - StartCycles;
+
+	Current = Parent;
+	if (Parent)
+	{
+		Parent->StartCycles = EndCycles;
+	}
+}
+
+void FTurretStats::PublishFrame(int32 NumTurrets, int32 NumProjectiles)
+{
+	SET_DWORD_STAT(STAT_TurretAI_ActiveTurrets, NumTurrets);
+	SET_DWORD_STAT(STAT_TurretAI_LiveProjectiles, NumProjectiles);
+
+	TRACE_COUNTER_SET(TurretAI_ActiveTurrets, NumTurrets);
+	TRACE_COUNTER_SET(TurretAI_LiveProjectiles, NumProjectiles);
+	TRACE_COUNTER_SET(TurretAI_Traces, NumTraces);
+	TRACE_COUNTER_SET(TurretAI_FireEvents, NumFireEvents);
+
+	NumTraces = 0;
+	NumFireEvents = 0;
+}
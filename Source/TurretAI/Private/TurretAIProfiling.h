@@ -0,0 +1,124 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+DECLARE_STATS_GROUP(TEXT("TurretAI"), STATGROUP_TurretAI, STATCAT_Advanced);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Active Turrets"), STAT_TurretAI_ActiveTurrets, STATGROUP_TurretAI, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Projectiles"), STAT_TurretAI_LiveProjectiles, STATGROUP_TurretAI, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces"), STAT_TurretAI_Traces, STATGROUP_TurretAI, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Fire Events"), STAT_TurretAI_FireEvents, STATGROUP_TurretAI, );
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(TurretAI_ActiveTurrets);
+TRACE_DECLARE_INT_COUNTER_EXTERN(TurretAI_LiveProjectiles);
+TRACE_DECLARE_INT_COUNTER_EXTERN(TurretAI_Traces);
+TRACE_DECLARE_INT_COUNTER_EXTERN(TurretAI_FireEvents);
+
+/** Insights channel of the turret scopes, enabled with -trace=cpu,TurretAI */
+UE_TRACE_CHANNEL_EXTERN(TurretAIChannel);
+
+/** Cycle counter for stat TurretAI and a timing event on the TurretAI trace channel */
+#define TURRETAI_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, TurretAIChannel)
+
+/**
+ * Counters of the turret work that are published once per frame, as stats and as trace counters
+ */
+struct FTurretStats
+{
+	/** Traces started this frame */
+	static int32 NumTraces;
+
+	/** Shots sent to the clients this frame, these replace the fire RPCs */
+	static int32 NumFireEvents;
+
+	static void AddTraces(int32 Count)
+	{
+		INC_DWORD_STAT_BY(STAT_TurretAI_Traces, Count);
+		NumTraces += Count;
+	}
+
+	static void AddFireEvents(int32 Count)
+	{
+		INC_DWORD_STAT_BY(STAT_TurretAI_FireEvents, Count);
+		NumFireEvents += Count;
+	}
+
+	/** Setting the counters of this frame, called once per frame by the turret manager */
+	static void PublishFrame(int32 NumTurrets, int32 NumProjectiles);
+};
+
+/** Parts of the turret work that are measured separately by the combat benchmark */
+enum class ETurretProfileCategory : uint8
+{
+	/** Batched updates of the subsystems */
+	Tick,
+	/** Collecting and ranking the target candidates */
+	Targeting,
+	/** Starting the visibility and can hit target traces and handling their results */
+	Traces,
+	/** Spawning the projectiles and the fire effects */
+	Spawn,
+	/** Applying the damage of the projectile hits */
+	Damage,
+
+	Num
+};
+
+/**
+ * Game thread time of each category, only measured while the combat benchmark is running.
+ * The time is exclusive, nested scopes pause their parent so the categories add up to the total turret time.
+ */
+struct FTurretProfiler
+{
+	static bool bEnabled;
+
+	static uint64 Cycles[static_cast<int32>(ETurretProfileCategory::Num)];
+
+	static void Reset() { FMemory::Memzero(Cycles); }
+};
+
+class FTurretProfileScope
+{
+public:
+	explicit FTurretProfileScope(ETurretProfileCategory InCategory)
+		: Category(InCategory)
+	{
+		if (FTurretProfiler::bEnabled && IsInGameThread())
+		{
+			Begin();
+		}
+	}
+
+	~FTurretProfileScope()
+	{
+		if (bActive)
+		{
+			End();
+		}
+	}
+
+private:
+	void Begin();
+	void End();
+
+	/** Innermost active scope on the game thread */
+	static FTurretProfileScope* Current;
+
+	FTurretProfileScope* Parent = nullptr;
+
+	uint32 StartCycles = 0;
+
+	ETurretProfileCategory Category;
+
+	bool bActive = false;
+};
+
+#define TURRETAI_PROFILE_SCOPE(Category) FTurretProfileScope PREPROCESSOR_JOIN(TurretProfileScope_, __LINE__)(ETurretProfileCategory::Category)
@@ -0,0 +1,142 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Types/TurretAimSolver.h"
+
+#include "HAL/IConsoleManager.h"
+#include "TurretAI.h"
+
+bool FTurretAimSolver::SolveIntercept(const FVector& Origin, const FVector& TargetLocation, const FVector& TargetVelocity, float ProjectileSpeed, float GravityZ,
+	FVector& OutAimLocation, float& OutTimeOfFlight)
+{
+	OutAimLocation = TargetLocation;
+	OutTimeOfFlight = 0.0f;
+
+	if (ProjectileSpeed <= UE_KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	// Without gravity: |Offset + TargetVelocity * T| = ProjectileSpeed * T
+	const FVector Offset = TargetLocation - Origin;
+	const double A = TargetVelocity.SizeSquared() - FMath::Square(ProjectileSpeed);
+	const double B = 2.0 * FVector::DotProduct(Offset, TargetVelocity);
+	const double C = Offset.SizeSquared();
+
+	double Time;
+	if (FMath::IsNearlyZero(A))
+	{
+		// Target is as fast as the projectile
+		if (B >= 0.0)
+		{
+			return false;
+		}
+
+		Time = -C / B;
+	}
+	else
+	{
+		const double Discriminant = B * B - 4.0 * A * C;
+		if (Discriminant < 0.0)
+		{
+			return false;
+		}
+
+		const double Root = FMath::Sqrt(Discriminant);
+		const double T1 = (-B - Root) / (2.0 * A);
+		const double T2 = (-B + Root) / (2.0 * A);
+		Time = T1 > 0.0 && (T1 < T2 || T2 <= 0.0) ? T1 : T2;
+	}
+
+	if (Time <= 0.0)
+	{
+		return false;
+	}
+
+	// Raise the aim to compensate for the gravity drop, each step refines the time of flight for the raised aim
+	FVector AimLocation = TargetLocation + TargetVelocity * Time;
+	for (int32 i = 0; i < MaxIterations && GravityZ != 0.0f; ++i)
+	{
+		const FVector PredictedLocation = TargetLocation + TargetVelocity * Time;
+		AimLocation = PredictedLocation - FVector(0.0f, 0.0f, 0.5f * GravityZ * Time * Time);
+
+		const double NewTime = FVector::Distance(Origin, AimLocation) / ProjectileSpeed;
+		if (FMath::IsNearlyEqual(NewTime, Time, 1.0e-3))
+		{
+			Time = NewTime;
+			break;
+		}
+
+		Time = NewTime;
+	}
+
+	OutAimLocation = AimLocation;
+	OutTimeOfFlight = Time;
+	return true;
+}
+
+static void RunAimSolverBenchmark(const TArray<FString>& Args)
+{
+	const int32 NumSamples = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+	constexpr float HitRadius = 50.0f;
+	constexpr float GravityZ = -980.0f;
+
+	// Same seed on every run so the results are comparable between builds
+	FRandomStream RandomStream(1234);
+
+	TArray<FVector> Origins, TargetLocations, TargetVelocities;
+	TArray<float> Speeds;
+	Origins.Reserve(NumSamples);
+	TargetLocations.Reserve(NumSamples);
+	TargetVelocities.Reserve(NumSamples);
+	Speeds.Reserve(NumSamples);
+
+	for (int32 i = 0; i < NumSamples; ++i)
+	{
+		Origins.Add(FVector(0.0f, 0.0f, 100.0f));
+		TargetLocations.Add(RandomStream.GetUnitVector() * FVector(1.0f, 1.0f, 0.1f) * RandomStream.FRandRange(500.0f, 3000.0f));
+		TargetVelocities.Add(FVector(RandomStream.GetUnitVector() * FVector(1.0f, 1.0f, 0.0f)).GetSafeNormal() * RandomStream.FRandRange(0.0f, 600.0f));
+		Speeds.Add(RandomStream.FRandRange(2000.0f, 6000.0f));
+	}
+
+	TArray<FVector> AimLocations;
+	TArray<float> Times;
+	AimLocations.SetNumUninitialized(NumSamples);
+	Times.SetNumUninitialized(NumSamples);
+
+	int32 NumSolved = 0;
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumSamples; ++i)
+	{
+		NumSolved += FTurretAimSolver::SolveIntercept(Origins[i], TargetLocations[i], TargetVelocities[i], Speeds[i], GravityZ, AimLocations[i], Times[i]) ? 1 : 0;
+	}
+	const double SolveTime = FPlatformTime::Seconds() - StartTime;
+
+	// Fly the projectiles analytically and compare against aiming at the current target location with the gravity compensation
+	int32 NumLeadHits = 0;
+	int32 NumDirectHits = 0;
+	for (int32 i = 0; i < NumSamples; ++i)
+	{
+		const FVector Gravity(0.0f, 0.0f, GravityZ);
+
+		const float LeadTime = Times[i];
+		const FVector LeadDirection = (AimLocations[i] - Origins[i]).GetSafeNormal();
+		const FVector LeadLocation = Origins[i] + LeadDirection * Speeds[i] * LeadTime + 0.5f * Gravity * LeadTime * LeadTime;
+		NumLeadHits += FVector::Distance(LeadLocation, TargetLocations[i] + TargetVelocities[i] * LeadTime) <= HitRadius ? 1 : 0;
+
+		// Same gravity compensation without the lead, so the hit ratios only differ by the lead solve
+		FVector DirectAimLocation;
+		float DirectTime;
+		FTurretAimSolver::SolveIntercept(Origins[i], TargetLocations[i], FVector::ZeroVector, Speeds[i], GravityZ, DirectAimLocation, DirectTime);
+		const FVector DirectDirection = (DirectAimLocation - Origins[i]).GetSafeNormal();
+		const FVector DirectLocation = Origins[i] + DirectDirection * Speeds[i] * DirectTime + 0.5f * Gravity * DirectTime * DirectTime;
+		NumDirectHits += FVector::Distance(DirectLocation, TargetLocations[i] + TargetVelocities[i] * DirectTime) <= HitRadius ? 1 : 0;
+	}
+
+	UE_LOG(LogTurretAI, Display, TEXT("Aim solver benchmark: %d samples, %d solved, %.3f us per solve, lead hit ratio %.1f%%, gravity compensated direct hit ratio %.1f%%"),
+		NumSamples, NumSolved, SolveTime * 1.0e6 / NumSamples, 100.0f * NumLeadHits / NumSamples, 100.0f * NumDirectHits / NumSamples);
+}
+
+static FAutoConsoleCommand AimSolverBenchmarkCommand(
+	TEXT("TurretAI.Benchmark.AimSolver"),
+	TEXT("Measures the cost and the hit ratio of the lead aim solver against a gravity compensated aim at the current target location. Usage: TurretAI.Benchmark.AimSolver [NumSamples]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunAimSolverBenchmark));
@@ -0,0 +1,51 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Types/TurretAimState.h"
+
+#include "GameFramework/Actor.h"
+#include "UObject/CoreNet.h"
+
+FRotator FTurretAimState::GetRotation() const
+{
+	// Decompressed axes are in [0, 360), the turret compares them with relative rotations in [-180, 180]
+	return FRotator(FRotator::NormalizeAxis(FRotator::DecompressAxisFromShort(Pitch)),
+		FRotator::NormalizeAxis(FRotator::DecompressAxisFromShort(Yaw)), 0.0f);
+}
+
+void FTurretAimState::SetRotation(float InYaw, float InPitch)
+{
+	Yaw = FRotator::CompressAxisToShort(InYaw);
+	Pitch = FRotator::CompressAxisToShort(InPitch);
+}
+
+bool FTurretAimState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint8 bHasTargetBit = bHasTarget;
+	Ar.SerializeBits(&bHasTargetBit, 1);
+	bHasTarget = bHasTargetBit;
+
+	Ar << Yaw;
+	Ar << Pitch;
+	Ar << ServerTime;
+	Ar << SweepPeriod;
+
+	// The target is sent as a network GUID, so it is only serialized when there is one
+	if (bHasTarget)
+	{
+		UObject* TargetObject = Target;
+		bOutSuccess &= Map->SerializeObject(Ar, AActor::StaticClass(), TargetObject);
+
+		if (Ar.IsLoading())
+		{
+			Target = Cast<AActor>(TargetObject);
+		}
+	}
+	else if (Ar.IsLoading())
+	{
+		Target = nullptr;
+	}
+
+	return true;
+}
@@ -0,0 +1,61 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Types/TurretArchetype.h"
+
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Subsystems/TurretManagerSubsystem.h"
+#include "TurretAI.h"
+#include "UObject/UObjectIterator.h"
+
+const FPrimaryAssetType UTurretArchetype::PrimaryAssetType(TEXT("TurretArchetype"));
+const FName UTurretArchetype::GameBundle(TEXT("Game"));
+
+static FAutoConsoleCommandWithWorld ReloadArchetypesCommand(
+	TEXT("TurretAI.Archetype.Reload"),
+	TEXT("Reads the config overrides of all loaded turret archetypes and updates the turrets that use them, on servers and clients alike. Remote machines read their own config files, so run it on each of them"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&UTurretArchetype::ReloadArchetypes));
+
+FPrimaryAssetId UTurretArchetype::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+void UTurretArchetype::PostLoad()
+{
+	Super::PostLoad();
+
+	LoadConfig();
+}
+
+#if WITH_EDITOR
+void UTurretArchetype::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Turrets that are already playing cache some of the values
+	for (TObjectIterator<UTurretManagerSubsystem> It; It; ++It)
+	{
+		It->RefreshTurretInfos();
+	}
+}
+#endif
+
+void UTurretArchetype::ReloadArchetypes(UWorld* World)
+{
+	int32 NumArchetypes = 0;
+	for (TObjectIterator<UTurretArchetype> It; It; ++It)
+	{
+		It->ReloadConfig();
+		++NumArchetypes;
+	}
+
+	// The archetypes are shared by all worlds, so the clients and the server of the same process are refreshed together
+	for (TObjectIterator<UTurretManagerSubsystem> It; It; ++It)
+	{
+		It->RefreshTurretInfos();
+	}
+
+	UE_LOG(LogTurretAI, Log, TEXT("Reloaded %d turret archetypes"), NumArchetypes);
+}
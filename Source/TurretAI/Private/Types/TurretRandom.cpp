@@ -0,0 +1,146 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#include "Types/TurretRandom.h"
+
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+#include "TurretAI.h"
+#include "Types/TurretAimState.h"
+
+static TAutoConsoleVariable<int32> CVarTurretWorldSeed(
+	TEXT("TurretAI.WorldSeed"),
+	0,
+	TEXT("Seed of the turret random streams, combined with the map name and the turret name. Must match on the server and the clients."),
+	ECVF_Default);
+
+int32 FTurretRandom::MakeTurretSeed(const UWorld* World, FName TurretName)
+{
+	// The PIE prefix differs between the PIE instances, without it the seed is the same on every instance
+	const uint32 MapHash = World ? GetTypeHash(UWorld::RemovePIEPrefix(World->GetMapName())) : 0;
+	return static_cast<int32>(HashCombine(HashCombine(static_cast<uint32>(CVarTurretWorldSeed.GetValueOnGameThread()), MapHash), GetTypeHash(TurretName.ToString())));
+}
+
+FRandomStream FTurretRandom::MakeSweepStream(int32 TurretSeed, uint16 SweepPeriod)
+{
+	return FRandomStream(static_cast<int32>(HashCombine(static_cast<uint32>(TurretSeed), SweepPeriod)));
+}
+
+FRotator FTurretRandom::MakeSweepRotation(FRandomStream& Stream, float MinPitch, float MaxPitch)
+{
+	const float Pitch = Stream.FRandRange(MinPitch, MaxPitch);
+	const float Yaw = Stream.FRandRange(-180.0f, 180.0f);
+	return FRotator(Pitch, Yaw, 0.0f);
+}
+
+FRotator FTurretRandom::MakeSpreadOffset(FRandomStream& Stream, float Spread)
+{
+	FRotator Offset;
+	Offset.Pitch = Stream.FRandRange(-Spread, Spread);
+	Offset.Yaw = Stream.FRandRange(-Spread, Spread);
+	Offset.Roll = Stream.FRandRange(-Spread, Spread);
+	return Offset;
+}
+
+void FTurretRandom::MakeSpreadOffsets(uint16 ShotSeed, float Spread, TArrayView<FRotator> OutOffsets)
+{
+	FRandomStream Stream(ShotSeed);
+	for (FRotator& Offset : OutOffsets)
+	{
+		Offset = MakeSpreadOffset(Stream, Spread);
+	}
+}
+
+/** Writes the value as it is sent to the clients and returns the value that the client reads */
+template <typename T>
+static T SendToClient(T Value)
+{
+	FBitWriter Writer(0, true);
+	Writer << Value;
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	T ReceivedValue = 0;
+	Reader << ReceivedValue;
+	return ReceivedValue;
+}
+
+/**
+ * Runs the server side of many turrets, sends the replicated values through the same serialization as the game,
+ * and checks that the simulated client regenerates bit-identical shots and idle sweeps.
+ * Only the server derives the turret seed, the client replays the shots and the sweeps from the seed that it has received.
+ */
+static void RunDeterminismTest(const TArray<FString>& Args, UWorld* World)
+{
+	const int32 NumTurrets = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 64;
+	const int32 NumShots = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 32;
+	constexpr int32 NumPellets = 3;
+	constexpr int32 NumSweeps = 8;
+	constexpr float Spread = 5.0f;
+	constexpr float MinPitch = -30.0f;
+	constexpr float MaxPitch = 45.0f;
+
+	int32 NumMismatches = 0;
+
+	for (int32 TurretIndex = 0; TurretIndex < NumTurrets; ++TurretIndex)
+	{
+		// The seed is replicated once with the initial state of the turret
+		const FName TurretName(*FString::Printf(TEXT("Turret_%d"), TurretIndex));
+		const int32 ServerSeed = FTurretRandom::MakeTurretSeed(World, TurretName);
+		const int32 ClientSeed = SendToClient(ServerSeed);
+
+		FRandomStream FireStream(ServerSeed);
+
+		for (int32 Shot = 0; Shot < NumShots; ++Shot)
+		{
+			const uint16 ServerShotSeed = static_cast<uint16>(FireStream.GetUnsignedInt());
+			const uint16 ClientShotSeed = SendToClient(ServerShotSeed);
+
+			// Same spread as the shotgun generates in PlayFireEvent
+			FRotator ServerOffsets[NumPellets];
+			FRotator ClientOffsets[NumPellets];
+			FTurretRandom::MakeSpreadOffsets(ServerShotSeed, Spread, ServerOffsets);
+			FTurretRandom::MakeSpreadOffsets(ClientShotSeed, Spread, ClientOffsets);
+			NumMismatches += FMemory::Memcmp(ServerOffsets, ClientOffsets, sizeof(ServerOffsets)) != 0 ? 1 : 0;
+		}
+
+		// Each lost target starts a new idle period, the period is sent in the aim state
+		for (uint16 SweepPeriod = 0; SweepPeriod < 4; ++SweepPeriod)
+		{
+			FTurretAimState ServerState;
+			ServerState.SweepPeriod = SweepPeriod;
+			ServerState.SetRotation(FireStream.FRandRange(-180.0f, 180.0f), FireStream.FRandRange(MinPitch, MaxPitch));
+
+			bool bSuccess = false;
+			FBitWriter Writer(0, true);
+			ServerState.NetSerialize(Writer, nullptr, bSuccess);
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			FTurretAimState ClientState;
+			ClientState.NetSerialize(Reader, nullptr, bSuccess);
+
+			NumMismatches += ClientState.GetRotation() != ServerState.GetRotation() ? 1 : 0;
+
+			FRandomStream ServerSweep = FTurretRandom::MakeSweepStream(ServerSeed, ServerState.SweepPeriod);
+			FRandomStream ClientSweep = FTurretRandom::MakeSweepStream(ClientSeed, ClientState.SweepPeriod);
+			for (int32 Sweep = 0; Sweep < NumSweeps; ++Sweep)
+			{
+				const FRotator ServerRotation = FTurretRandom::MakeSweepRotation(ServerSweep, MinPitch, MaxPitch);
+				const FRotator ClientRotation = FTurretRandom::MakeSweepRotation(ClientSweep, MinPitch, MaxPitch);
+				NumMismatches += FMemory::Memcmp(&ServerRotation, &ClientRotation, sizeof(FRotator)) != 0 ? 1 : 0;
+			}
+		}
+	}
+
+	if (NumMismatches > 0)
+	{
+		UE_LOG(LogTurretAI, Error, TEXT("Determinism test failed: %d mismatches between the server and the client, %d turrets, %d shots each"), NumMismatches, NumTurrets, NumShots);
+	}
+	else
+	{
+		UE_LOG(LogTurretAI, Display, TEXT("Determinism test passed: %d turrets, %d shots each"), NumTurrets, NumShots);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs DeterminismTestCommand(
+	TEXT("TurretAI.Test.Determinism"),
+	TEXT("Checks that a simulated client regenerates bit-identical shotgun spreads and idle sweeps from the replicated values. Usage: TurretAI.Test.Determinism [NumTurrets] [NumShots]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunDeterminismTest));
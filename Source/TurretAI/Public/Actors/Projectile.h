@@ -8,6 +8,7 @@
 #include "Projectile.generated.h"
 
 class UNiagaraSystem;
+class UProjectileMovementComponent;
 
 enum EProjectileAbility
 {
@@ -22,6 +23,8 @@ UCLASS(meta = (DisplayName = "Projectile"))
 class TURRETAI_API AProjectile : public AActor
 {
 	GENERATED_BODY()
+
+	friend class UProjectilePoolSubsystem;
 	
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = true))
 	TObjectPtr<UStaticMeshComponent> ProjectileMesh;
@@ -30,7 +33,7 @@ class TURRETAI_API AProjectile : public AActor
 	TObjectPtr<class UNiagaraComponent> TrailParticle;
 	
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = true))
-	TObjectPtr<class UProjectileMovementComponent> ProjectileMovement;
+	TObjectPtr<UProjectileMovementComponent> ProjectileMovement;
 
 // Functions
 public:
@@ -47,19 +50,48 @@ public:
 		return (ProjectileAbility & static_cast<int32>(Flag)) == static_cast<int32>(Flag);
 	}
 
+	/** Resetting a pooled projectile to its default state and firing it from its current transform */
+	void ActivateFromPool();
+
+	/** Hiding the projectile and stopping its movement, trail, and lifespan while it waits in the pool */
+	void DeactivateToPool();
+
+	UStaticMeshComponent* GetProjectileMesh() const { return ProjectileMesh; }
+
+	UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
+
+	const FRadialDamageParams& GetDamageInfo() const { return DamageInfo; }
+
+	const TSoftObjectPtr<UNiagaraSystem>& GetHitParticle() const { return HitParticle; }
+
+	const TSoftObjectPtr<USoundBase>& GetHitSound() const { return HitSound; }
+
+	/** Shared with the simulated projectiles so both projectile backends apply the same damage */
+	static void ApplyNormalHit(const FRadialDamageParams& InDamageInfo, const FHitResult& HitResult, AController* InstigatorController, AActor* DamageCauser);
+	static void ApplyExplosiveHit(const UObject* WorldContextObject, const FRadialDamageParams& InDamageInfo, const FHitResult& HitResult, AController* InstigatorController, AActor* DamageCauser);
+
 protected:
 	/** Called when the game starts or when spawned */
 	virtual void BeginPlay() override;
 
+	/** Removing the projectile from the active projectiles of the pool when it is destroyed without being released */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Returning the projectile to the pool instead of destroying it */
+	virtual void LifeSpanExpired() override;
+
 private:
 	void LoadAssets();
+
+	/** Reading the soft references after they are loaded */
+	void ResolveAssets();
+
+	/** Applying the state that is set before firing the projectile */
+	void InitializeMovement();
 	
 	UFUNCTION()
 	void ProjectileHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
-	void ApplyNormalHit(const FHitResult& HitResult) const;
-	void ApplyExplosiveHit(const FHitResult& HitResult) const;
-
 	/** Disabling the projectile after hit and destroying it with a delay so trail particles have time to disappear */
 	void DisableProjectile();
 
@@ -87,4 +119,7 @@ private:
 	USoundBase* HitSoundLoaded;
 	
 	uint8 bDoOnceHit : 1;
+
+	/** Acquired from the pool and not released yet, counted in the active projectiles of the pool */
+	uint8 bActiveInPool : 1;
 };
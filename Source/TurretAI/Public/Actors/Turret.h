@@ -5,7 +5,11 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "Interfaces/GameplayInterface.h"
+#include "Subsystems/TurretSchedulerSubsystem.h"
+#include "Types/TurretAimState.h"
+#include "Types/TurretArchetype.h"
 #include "Types/TurretTypes.h"
+#include "WorldCollision.h"
 #include "Turret.generated.h"
 
 class UNiagaraSystem;
@@ -18,6 +22,30 @@ class TURRETAI_API ATurret : public AActor, public IGameplayInterface
 {
 	GENERATED_BODY()
 
+	friend class UTurretManagerSubsystem;
+	friend class UTurretProxySubsystem;
+	friend class UTurretSchedulerSubsystem;
+	friend class UTurretTargetSubsystem;
+
+	/** Data of a target candidate that the score needs, read on the game thread so the ranking doesn't touch any actor */
+	struct FTargetSnapshot
+	{
+		AActor* Target = nullptr;
+		FVector Location = FVector::ZeroVector;
+		float HealthRatio = 1.0f;
+		bool bPlayerControlled = false;
+	};
+
+	/** Result of a can hit check and the aim that it was made with */
+	struct FCanHitCache
+	{
+		TWeakObjectPtr<AActor> Target;
+		FVector Direction = FVector::ZeroVector;
+		FVector AimLocation = FVector::ZeroVector;
+		float Time = -UE_BIG_NUMBER;
+		bool bCanHit = false;
+	};
+
 protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = true))
 	TObjectPtr<UStaticMeshComponent> BaseMesh;
@@ -36,31 +64,76 @@ private:
 public:
 	/** Sets default values for this actor's properties */
 	ATurret();
-	
-	/** Called every frame */
-	virtual void Tick(float DeltaTime) override;
 
 	virtual void Destroyed() override;
 
-	//~ Begin Gameplay Interface
-	virtual void HealthChanged() override;
-	//~ End Gameplay Interface
+	/** Clients remove the torn off turrets that were replaced by a proxy */
+	virtual void TornOff() override;
+
+	/** Component that rotates around the yaw axis to follow the target */
+	virtual UStaticMeshComponent* GetYawComponent() const { return BarrelMesh; }
+
+	/** Component that rotates around the pitch axis to follow the target */
+	UStaticMeshComponent* GetPitchComponent() const { return BarrelMesh; }
+
+	/** Info of the archetype if the turret has one, otherwise the info of the class */
+	const FTurretInfo& GetTurretInfo() const { return ArchetypeLoaded ? ArchetypeLoaded->TurretInfo : TurretInfo; }
+
+	const UTurretArchetype* GetArchetype() const { return ArchetypeLoaded; }
+
+	AActor* GetCurrentTarget() const { return CurrentTarget; }
+
+	ETurretState GetState() const { return State; }
+
+	/** Waking up a dormant turret, the server searches for a target and clients restart the idle sweep */
+	void Wake();
+
+	const FRotator& GetRandomRotation() const { return RandomRotation; }
+
+	/** Location that the turret should aim at, leads the current target for non-homing projectiles */
+	FVector GetAimLocation() const;
+
+	/**
+	* Spawning the projectiles and the effects of a shot, called on the server and on the clients for each fire event
+	* @param	Seed	Seed of the random values of the shot, the same seed gives the same shot on every machine
+	*/
+	virtual void PlayFireEvent(uint16 Seed);
 
 protected:
 	/** Called when the game starts or when spawned */
 	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
-	virtual void HandleFireTurret();
+	/** Firing on the server and sending the fire event to the clients */
+	void HandleFireTurret();
+
+	/** Homing projectiles need the target, other projectiles can be fired before the target is replicated */
+	bool CanPlayFireEvent() const { return CurrentTarget || GetTurretInfo().HasFlag(ETurretAbility::Homing) == false; }
 
 	void SpawnProjectile(const FTransform& Transform);
 
 	void SpawnFireFX() const;
-	
-	/** Calculating the target rotation so the turret will smoothly rotate toward the target */
-	FRotator CalculateRotation(const UStaticMeshComponent* CompToRotate, float DeltaTime) const;
+
+	/** True if the turret is destroyed during the game, false if it is unloaded or replaced by a proxy, which don't leave any debris */
+	bool IsDestroyedInPlay() const;
 	
 private:
 	void LoadAssets();
+
+	/** Requesting the soft references of the class when the turret doesn't have an archetype */
+	void LoadClassAssets();
+
+	/** Soft references of the class, the turret proxies of the class request the same paths */
+	void GetClassAssetPaths(TArray<FSoftObjectPath>& OutPaths) const;
+
+	void OnArchetypeLoaded();
+
+	/** Reading the soft references after they are loaded */
+	void ResolveAssets();
+
+	/** Filling the projectile pool so the first shots don't need to spawn new projectiles */
+	void PrewarmProjectiles() const;
 	
 	UFUNCTION()
 	void DetectorBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
@@ -74,37 +147,108 @@ private:
 	/** @note Should not be called directly, use FindNewTarget() */
 	void FindNewTargetImpl();
 
+	/**
+	* First step of the search, collecting the target candidates and their snapshots on the game thread
+	* @return	False if there is no candidate, the turret enters dormancy
+	*/
+	bool GatherTargetCandidates();
+
+	/** Collecting the actors inside the detector based on the detection mode */
+	void GetTargetsInRange(TArray<AActor*>& OutTargets);
+
+	/** Sorting the candidates by their score and keeping the best ones for the visibility checks, only reads the snapshots so it can run on any thread */
+	void RankTargets();
+
+	float ScoreTarget(const FTargetSnapshot& Snapshot) const;
+
 	/** Trying to fire the turret based on the current state of the target (enemy). */
 	void StartFireTurret();
 
 	/** Handling firing the turret */
 	void FireTurret();
 	
-	UFUNCTION(NetMulticast, Unreliable)
-	void MulticastFireTurret();
-	void MulticastFireTurret_Implementation();
-
-	/** Finding a new random rotation for the turret to use when there is no enemy */
+	/** Finding a new random rotation for the turret to use when there is no enemy, idle sweeps are local to each machine */
 	void FindRandomRotation();
+
+	/** Changing the target on the server and writing the replicated aim state */
+	void SetCurrentTarget(AActor* NewTarget);
+
+	/** Idle turrets have nothing to replicate, they are woken up when they find a target */
+	void EnterDormancy();
+
+	/** Scheduling the task in the turret scheduler, does nothing before the turret has begun play */
+	void ScheduleTask(ETurretTask Task, float Delay);
+
+	void CancelTask(ETurretTask Task);
+
+	void SetState(ETurretState NewState);
+
+	/**
+	* Sweeping for the idle sweep duration and then going dormant, dedicated servers go dormant immediately
+	* @param	Delay	Seconds before the first random rotation
+	*/
+	void StartIdleSweep(float Delay);
+
+	/** Entering the dormant state, cancels all scheduled tasks and stops the replication until the turret is woken up */
+	void Sleep();
+
+	/** Removing the turret that is replaced by a proxy, a networked turret is torn off first so the clients learn why it is removed */
+	void DemoteToProxy();
+
+	/** Called once per frame with the sum of the damage of that frame */
+	void OnHealthChanged(UHealthComponent* Component, float Delta, float NewHealth);
+
+	UFUNCTION()
+	void OnRep_AimState();
+
+	/** The seed can arrive after the aim state, so the idle sweep is restarted from the seed of the server */
+	UFUNCTION()
+	void OnRep_RandomSeed();
 	
-	/** A simple test to make sure that the turret can see the target and target is not behind any cover */
-	bool CanSeeTarget(AActor* Target) const;
+	/**
+	* A simple test to make sure that the turret can see the targets and targets are not behind any cover.
+	* Traces are batched by the world and the results are used on the next frame, the first visible target is selected.
+	*/
+	void RequestCanSeeTargets(const TArray<AActor*>& Targets);
+
+	void OnCanSeeTargetTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	/**
+	* Checking the next ranked candidates after all checked candidates were blocked
+	* @return	False if there are no candidates left
+	*/
+	bool RequestNextCanSeeTargets();
 
 	/**
-	* Checking the target state and see that can projectile hit the target
-	* @param	Target	Target actor that we try to hit
-	* @return	True if the projectile can hit the target
+	* Checking the current target state and see that can projectile hit the target, the result is used on the next frame.
+	* Projectiles that are affected by gravity are swept in segments along their predicted arc, and a recent result is reused while the aim is stable.
+	* @param	bDropTargetOnMiss	If true, the turret will search for a new target when the projectile can't hit the current target
 	*/
-	virtual bool CanHitTarget(AActor* Target) const;
+	virtual void RequestCanHitTarget(bool bDropTargetOnMiss);
+
+	void OnCanHitTargetTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	/** Firing the turret or dropping the target based on the can hit target check */
+	void HandleCanHitResult(bool bCanHit, bool bDropTargetOnMiss);
+
+	/** Checking that the first blocking hit of the trace is the target */
+	static bool IsTargetHit(const FTraceDatum& TraceDatum, const AActor* Target);
 	
 // Variables
 protected:
-	/** Turret info structure that stores the essential data to initialize the turret */
+	/** Turret info structure that stores the essential data to initialize the turret, replaced by the info of the archetype */
 	UPROPERTY(EditDefaultsOnly, Category = "Turret")
 	FTurretInfo TurretInfo;
 
-	/** The current enemy that the turret try to shoot at it */
-	UPROPERTY(Replicated)
+	/** Shared turret info, projectile and effects, the values of the class are used if there is no archetype */
+	UPROPERTY(EditAnywhere, Category = "Turret")
+	TSoftObjectPtr<UTurretArchetype> Archetype;
+
+	UPROPERTY()
+	TObjectPtr<UTurretArchetype> ArchetypeLoaded;
+
+	/** The current enemy that the turret try to shoot at it, replicated through the aim state */
+	UPROPERTY()
 	AActor* CurrentTarget;
 
 private:
@@ -114,6 +258,66 @@ private:
 	UPROPERTY()
 	UClass* ProjectileLoaded;
 
+	/** Initial speed of the projectile, read from the projectile class */
+	float ProjectileSpeed = 0.0f;
+
+	/** Gravity acceleration of the projectile, read from the projectile class */
+	float ProjectileGravityZ = 0.0f;
+
+	/** Collision radius of the projectile, read from the projectile class */
+	float ProjectileRadius = 50.0f;
+
+	/** Maximum angle in degrees between the barrel and the predicted target location to fire a non-homing projectile */
+	UPROPERTY(EditDefaultsOnly, Category = "Turret", meta = (AllowPrivateAccess = true, ClampMin = 0.0, UIMin = 0.0))
+	float LeadAimTolerance = 2.0f;
+
+	/** Number of sweeps along the predicted arc of the projectiles that are affected by gravity */
+	UPROPERTY(EditDefaultsOnly, Category = "Turret|Fire Control", meta = (AllowPrivateAccess = true, ClampMin = 1, UIMin = 1))
+	int32 NumArcSegments = 4;
+
+	/** Seconds that the result of a can hit check is reused while the target and the aim don't change */
+	UPROPERTY(EditDefaultsOnly, Category = "Turret|Fire Control", meta = (AllowPrivateAccess = true, ClampMin = 0.0, UIMin = 0.0))
+	float CanHitCacheDuration = 0.5f;
+
+	/** Maximum change of the barrel direction in degrees to reuse the result of a can hit check */
+	UPROPERTY(EditDefaultsOnly, Category = "Turret|Fire Control", meta = (AllowPrivateAccess = true, ClampMin = 0.0, UIMin = 0.0))
+	float CanHitCacheAngle = 1.0f;
+
+	/**
+	* Yaw and pitch parts are only visual, they have no collision so rotating them doesn't move physics bodies or update overlaps.
+	* Projectiles and traces still hit the base mesh.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "Turret", meta = (AllowPrivateAccess = true))
+	uint8 bCosmeticRotatingParts : 1;
+
+	/** Simulated projectiles are much lighter than projectile actors, which is useful for high-volume fire */
+	UPROPERTY(EditDefaultsOnly, Category = "Turret", meta = (AllowPrivateAccess = true))
+	EProjectileBackend ProjectileBackend = EProjectileBackend::Actor;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turret", meta = (AllowPrivateAccess = true))
+	FTurretTargetScoring TargetScoring;
+
+	/** Actors inside the detector, updated by the overlap events so the turret doesn't need to query the overlaps on each search */
+	TArray<TWeakObjectPtr<AActor>> DetectedActors;
+
+	/** Reused between the searches to avoid allocating new arrays */
+	TArray<AActor*> TargetCandidates;
+	TArray<FTargetSnapshot> TargetSnapshots;
+	TArray<TPair<float, AActor*>> ScoredTargets;
+
+	/** Ranked candidates after the checked ones, the next ones are checked when none of the checked candidates is visible */
+	TArray<TWeakObjectPtr<AActor>> VisibilityFallbacks;
+	int32 NextVisibilityFallback = 0;
+
+	/** Detector and barrel of the current search */
+	FVector SearchOrigin = FVector::ZeroVector;
+	FVector SearchForward = FVector::ForwardVector;
+	float SearchRadius = 0.0f;
+
+	/** Spatial index avoids the overlap bookkeeping of the detector, which is more efficient with many turrets and pawns */
+	UPROPERTY(EditDefaultsOnly, Category = "Turret", meta = (AllowPrivateAccess = true))
+	ETurretDetectionMode DetectionMode = ETurretDetectionMode::Overlap;
+
 	UPROPERTY(EditDefaultsOnly, Category = "Turret", meta = (AllowPrivateAccess = true))
 	TSoftObjectPtr<UNiagaraSystem> FireParticle;
 	
@@ -139,15 +343,72 @@ private:
 	USoundBase* DestroySoundLoaded;
 
 	/** Target rotation that the turret will try to look at when there is no enemy */
-	UPROPERTY(Replicated)
 	FRotator RandomRotation = FRotator::ZeroRotator;
 
-	/** If set to True, the turret will try to find and look at a random rotation. */
-	uint8 bCanRotateRandomly : 1;
+	ETurretState State = ETurretState::IdleSweep;
+
+	/** Seconds that the turret sweeps after losing its target before it goes dormant */
+	UPROPERTY(EditDefaultsOnly, Category = "Turret", meta = (AllowPrivateAccess = true, ClampMin = 0.0, UIMin = 0.0))
+	float IdleSweepDuration = 10.0f;
+
+	/** World time when the current idle sweep ends */
+	float IdleSweepEndTime = 0.0f;
+
+	UPROPERTY(ReplicatedUsing = OnRep_AimState)
+	FTurretAimState AimState;
+
+	/** Seed of the random streams of the turret, made from the world seed and the turret on the server */
+	UPROPERTY(ReplicatedUsing = OnRep_RandomSeed)
+	int32 RandomSeed = 0;
+
+	/** Seeds of the shots, only used on the server */
+	FRandomStream FireRandomStream;
+
+	/** Rotations of the current idle sweep, restarted on every machine when the turret loses its target */
+	FRandomStream SweepRandomStream;
+
+	/** Maximum time that clients advance the aim to catch up with the server */
+	UPROPERTY(EditDefaultsOnly, Category = "Turret|Replication", meta = (AllowPrivateAccess = true, ClampMin = 0.0, UIMin = 0.0))
+	float MaxAimExtrapolationTime = 0.5f;
+
+	/** Index of the turret in the turret manager, the rotation is updated by the manager instead of ticking the turret */
+	int32 ManagerIndex = INDEX_NONE;
 
-	/** Used to call FireTurret() in a loop */
-	FTimerHandle FireTimer;
+	/** Runs the target search, the fire loop and the random rotation of the turret */
+	UPROPERTY()
+	TObjectPtr<UTurretSchedulerSubsystem> Scheduler;
+
+	/** Sequence of the last scheduled task of each type, used by the scheduler to skip canceled tasks */
+	uint32 TaskSequences[static_cast<int32>(ETurretTask::Num)] = {};
+
+	/** Bit of each task type that is waiting to run in the scheduler */
+	uint8 ScheduledTasks = 0;
+
+	FTraceDelegate CanSeeTargetDelegate;
+	FTraceDelegate CanHitTargetDelegate;
+
+	/** Pending visibility traces of the current search, stale results are ignored */
+	TArray<FTraceHandle> CanSeeTraceHandles;
+
+	/** Candidates of the current search in the same order as the trace handles */
+	TArray<TWeakObjectPtr<AActor>> CanSeeCandidates;
+
+	/** Non-zero for each candidate that the turret can see */
+	TArray<uint8> CanSeeResults;
 
-	/** FindNewTarget() start this timer to recheck for a new target */
-	FTimerHandle SearchTimer;
+	int32 NumPendingCanSeeTraces = 0;
+
+	/** Pending sweeps of the segments of the current can hit check, in the order along the path */
+	TArray<FTraceHandle> CanHitTraceHandles;
+
+	/** Result of the sweep of each segment */
+	TArray<uint8> CanHitResults;
+
+	int32 NumPendingCanHitTraces = 0;
+
+	FCanHitCache CanHitCache;
+
+	/** Set by the proxy subsystem when the turret is replaced by a proxy, replicated with the tear off so the clients skip the destruction effects too */
+	UPROPERTY(Replicated)
+	uint8 bDemotedToProxy : 1;
 };
@@ -15,16 +15,13 @@ class TURRETAI_API ATurretShotgun : public ATurret
 	GENERATED_BODY()
 
 // Functions
-protected:
-	virtual void HandleFireTurret() override;
-
-private:
-	UFUNCTION(NetMulticast, Unreliable)
-	void MulticastFireShotgunTurret(const TArray<FRotator>& Rotations);
-	void MulticastFireShotgunTurret_Implementation(const TArray<FRotator>& Rotations);
+public:
+	/** Firing all the shots of the volley, the spread of each shot is generated from the seed */
+	virtual void PlayFireEvent(uint16 Seed) override;
 
 // Variables
 private:
+	/** Replaced by the shotgun values of the archetype */
 	UPROPERTY(EditDefaultsOnly, Category = "Turret", meta = (AllowPrivateAccess = true, ClampMin = 1, UIMin = 1))
 	uint8 NumOfShots = 3;
 	
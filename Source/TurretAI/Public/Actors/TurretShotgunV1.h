@@ -13,9 +13,4 @@ UCLASS(Blueprintable, meta = (DisplayName = "Shotgun Turret AI V1"))
 class TURRETAI_API ATurretShotgunV1 : public ATurretShotgun
 {
 	GENERATED_BODY()
-
-// Functions
-public:
-	/** Called every frame */
-	virtual void Tick(float DeltaTime) override;
 };
@@ -13,9 +13,4 @@ UCLASS(Blueprintable, meta = (DisplayName = "Turret AI V1"))
 class TURRETAI_API ATurretV1 : public ATurret
 {
 	GENERATED_BODY()
-
-// Functions
-public:
-	/** Called every frame */
-	virtual void Tick(float DeltaTime) override;
 };
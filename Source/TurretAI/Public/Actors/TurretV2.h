@@ -22,8 +22,7 @@ public:
 	/** Sets default values for this actor's properties */
 	ATurretV2();
 	
-	/** Called every frame */
-	virtual void Tick(float DeltaTime) override;
-
 	virtual void Destroyed() override;
+
+	virtual UStaticMeshComponent* GetYawComponent() const override { return TurretMesh; }
 };
@@ -0,0 +1,85 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DamageResolverSubsystem.generated.h"
+
+/**
+ * Resolves the explosions of a frame together instead of a radial damage query for each explosion.
+ * Overlapping blast spheres are merged into one overlap query, the falloff of all explosions is computed for each victim in a single pass,
+ * and each victim takes the sum of the damage once per frame.
+ */
+UCLASS(Config = Game)
+class TURRETAI_API UDamageResolverSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	struct FPendingExplosion
+	{
+		FRadialDamageParams DamageInfo;
+		FVector Origin;
+		TWeakObjectPtr<AController> InstigatorController;
+		TWeakObjectPtr<AActor> DamageCauser;
+	};
+
+	/** Explosions whose blast spheres overlap, queried with a single sphere that contains all of them */
+	struct FExplosionCluster
+	{
+		FSphere Bounds;
+		TArray<int32, TInlineAllocator<8>> Explosions;
+	};
+
+	struct FVictimDamage
+	{
+		float Damage = 0.0f;
+
+		/** Largest single contribution, its instigator and causer are reported with the total damage */
+		float MaxDamage = 0.0f;
+
+		AController* InstigatorController = nullptr;
+		AActor* DamageCauser = nullptr;
+	};
+
+// Functions
+public:
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/** Adding an explosion to the current frame, the damage is applied at the end of the frame */
+	void AddExplosion(const FRadialDamageParams& DamageInfo, const FVector& Origin, AController* InstigatorController, AActor* DamageCauser);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void BuildClusters();
+
+	/** Querying the victims of the cluster and adding the damage of its explosions to them */
+	void ResolveCluster(const FExplosionCluster& Cluster);
+
+	/** Same test as the engine radial damage, the blast is blocked by anything between the origin and the component */
+	bool IsComponentDamageableFrom(const UPrimitiveComponent* Component, const FVector& Origin, const AActor* DamageCauser) const;
+
+	void ApplyVictimDamages();
+
+// Variables
+private:
+	/** Clusters are not grown beyond this radius, so far apart explosions don't make a huge query */
+	UPROPERTY(Config)
+	float MaxClusterRadius = 2000.0f;
+
+	TArray<FPendingExplosion> Explosions;
+
+	TArray<FExplosionCluster> Clusters;
+
+	TMap<AActor*, FVictimDamage> VictimDamages;
+};
@@ -0,0 +1,92 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProjectilePoolSubsystem.generated.h"
+
+class AProjectile;
+
+/**
+ * Inactive projectiles of a single class and the pool usage of that class
+ */
+USTRUCT()
+struct FProjectilePool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TObjectPtr<AProjectile>> InactiveProjectiles;
+
+	/** Number of projectiles that were taken from the pool */
+	int32 NumHits = 0;
+
+	/** Number of projectiles that were spawned because the pool was empty */
+	int32 NumMisses = 0;
+
+	/** Number of projectiles that were destroyed because the pool was full */
+	int32 NumOverflows = 0;
+
+	bool bPrewarmed = false;
+};
+
+/**
+ * Per-world pool of projectiles, recycles the projectiles on hit or lifespan expiry instead of spawning and destroying them for each shot
+ */
+UCLASS(Config = Game)
+class TURRETAI_API UProjectilePoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+// Functions
+public:
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	/** Spawning the initial projectiles of the class, only the first call for each class has an effect */
+	void Prewarm(TSubclassOf<AProjectile> ProjectileClass);
+
+	/**
+	* Taking a projectile from the pool or spawning a deferred one if the pool is empty.
+	* The projectile can be initialized before calling LaunchProjectile().
+	*/
+	AProjectile* AcquireProjectile(TSubclassOf<AProjectile> ProjectileClass, const FTransform& Transform, AActor* Owner, APawn* Instigator);
+
+	/** Finishing the spawn of a new projectile or reactivating a pooled one */
+	static void LaunchProjectile(AProjectile* Projectile, const FTransform& Transform);
+
+	/**
+	* Returning the projectile to the pool
+	* @return	False if the pool of the projectile class is full and the projectile should be destroyed
+	*/
+	bool ReleaseProjectile(AProjectile* Projectile);
+
+	/** Stops counting an acquired projectile that is destroyed without being released */
+	void RemoveActiveProjectile(AProjectile* Projectile);
+
+	/** Writing the pool usage of each projectile class to the log */
+	void LogStats() const;
+
+	/** Number of projectiles that have been acquired and not released yet */
+	int32 GetNumActiveProjectiles() const { return NumActiveProjectiles; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+// Variables
+private:
+	/** Number of projectiles to spawn for each class when the pool is created */
+	UPROPERTY(Config)
+	int32 PrewarmCount = 16;
+
+	/** Maximum number of inactive projectiles for each class, extra projectiles are destroyed */
+	UPROPERTY(Config)
+	int32 MaxPoolSize = 256;
+
+	UPROPERTY()
+	TMap<TObjectPtr<UClass>, FProjectilePool> Pools;
+
+	int32 NumActiveProjectiles = 0;
+};
@@ -0,0 +1,119 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DamageEvents.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "ProjectileSimulationSubsystem.generated.h"
+
+class AProjectile;
+class UInstancedStaticMeshComponent;
+class UNiagaraSystem;
+
+/**
+ * Simulated projectiles of a single projectile class, the settings are read from the projectile class default object
+ */
+USTRUCT()
+struct FSimulatedProjectileGroup
+{
+	GENERATED_BODY()
+
+	/** Draws all projectiles of the group, not created on dedicated servers */
+	UPROPERTY()
+	TObjectPtr<UInstancedStaticMeshComponent> Instances;
+
+	UPROPERTY()
+	TObjectPtr<UNiagaraSystem> HitParticle;
+
+	UPROPERTY()
+	TObjectPtr<USoundBase> HitSound;
+
+	FRadialDamageParams DamageInfo;
+
+	/** Velocity of the projectile when it is fired, see bInitialVelocityInLocalSpace */
+	FVector InitialVelocity = FVector::ZeroVector;
+	bool bInitialVelocityInLocalSpace = true;
+
+	FName CollisionProfile;
+	float CollisionRadius = 0.0f;
+	float GravityZ = 0.0f;
+	float HomingAcceleration = 0.0f;
+	float MaxSpeed = 0.0f;
+	float LifeSpan = 0.0f;
+	FVector MeshScale = FVector::OneVector;
+
+	// Projectiles, stored as structure of arrays
+	TArray<FVector> Locations;
+	TArray<FVector> Velocities;
+	TArray<float> RemainingLifeSpans;
+	TArray<uint8> Explosive;
+	TArray<TWeakObjectPtr<USceneComponent>> HomingTargets;
+	TArray<TWeakObjectPtr<AActor>> Owners;
+	TArray<TWeakObjectPtr<APawn>> Instigators;
+
+	/** Sweep of the last movement of each projectile, the result is read on the next frame */
+	TArray<FTraceHandle> TraceHandles;
+
+	int32 Num() const { return Locations.Num(); }
+
+	void RemoveAtSwap(int32 Index);
+};
+
+/**
+ * Lightweight projectile backend, simulates ballistic and homing projectiles as plain data instead of actors.
+ * Each frame all projectiles are moved in one pass and their movement is checked with batched async sweeps.
+ */
+UCLASS()
+class TURRETAI_API UProjectileSimulationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+// Functions
+public:
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/**
+	* Firing a simulated projectile
+	* @param	ProjectileClass	The settings of the projectile are read from the class default object
+	* @param	Transform		Start location and direction of the projectile
+	* @param	HomingTarget	If valid, the projectile will follow this component
+	* @param	bExplosive		If true, radial damage is applied on hit
+	*/
+	void FireProjectile(TSubclassOf<AProjectile> ProjectileClass, const FTransform& Transform, AActor* Owner, APawn* Instigator, USceneComponent* HomingTarget, bool bExplosive);
+
+	int32 GetNumProjectiles() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	FSimulatedProjectileGroup& FindOrAddGroup(TSubclassOf<AProjectile> ProjectileClass);
+
+	/** Reading the sweep results of the last frame, hit or expired projectiles are removed */
+	void ResolveHits(FSimulatedProjectileGroup& Group) const;
+
+	/** Moving the projectiles and starting the sweeps for the new movement */
+	void MoveProjectiles(FSimulatedProjectileGroup& Group, float DeltaTime) const;
+
+	void ProjectileHit(const FSimulatedProjectileGroup& Group, int32 Index, const FHitResult& HitResult) const;
+
+	static void UpdateInstances(const FSimulatedProjectileGroup& Group);
+
+// Variables
+private:
+	UPROPERTY()
+	TMap<TObjectPtr<UClass>, FSimulatedProjectileGroup> Groups;
+
+	/** Owner of the instanced mesh components */
+	UPROPERTY()
+	TObjectPtr<AActor> VisualsActor;
+};
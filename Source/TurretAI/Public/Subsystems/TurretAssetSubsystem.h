@@ -0,0 +1,49 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "TurretAssetSubsystem.generated.h"
+
+/**
+ * Shares the soft referenced assets of the turrets and projectiles between all instances of the same class.
+ * The assets of each class are requested once and the streamable handle is kept alive,
+ * so later instances can resolve their soft references synchronously.
+ */
+UCLASS()
+class TURRETAI_API UTurretAssetSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+	struct FClassAssets
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+
+		/** Instances that are waiting for the assets to load */
+		TArray<FStreamableDelegate> PendingDelegates;
+	};
+
+// Functions
+public:
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	/**
+	* Requesting the assets of the class, only the first request of each class starts loading
+	* @param	Class		Instances of the same class should request the same paths
+	* @param	Paths		Soft references of the class
+	* @param	OnLoaded	Called when the assets are loaded, only if this function returns false
+	* @return	True if the assets are already loaded and can be resolved synchronously
+	*/
+	bool RequestClassAssets(const UClass* Class, const TArray<FSoftObjectPath>& Paths, FStreamableDelegate OnLoaded);
+
+private:
+	void ClassAssetsLoaded(TObjectKey<UClass> ClassKey);
+
+// Variables
+private:
+	TMap<TObjectKey<UClass>, FClassAssets> ClassAssets;
+};
@@ -0,0 +1,138 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TurretBenchmarkSubsystem.generated.h"
+
+class ATurret;
+
+/** Measurements of one frame of the combat benchmark */
+struct FTurretBenchmarkFrame
+{
+	float FrameTime = 0.0f;
+	float GameThreadTime = 0.0f;
+	float TickTime = 0.0f;
+	float TargetingTime = 0.0f;
+	float TraceTime = 0.0f;
+	float SpawnTime = 0.0f;
+	float DamageTime = 0.0f;
+	float GCTime = 0.0f;
+	int32 NumProjectiles = 0;
+	float UsedMemory = 0.0f;
+};
+
+/**
+ * Headless turret combat benchmark, spawns a grid of turrets and moving targets, runs the fight for a duration,
+ * and writes the per frame measurements to a CSV file and a summary to a JSON file in the profiling directory.
+ * Times are in milliseconds and memory is in megabytes.
+ * 
+ * Usage on a dedicated server:
+ * -nullrhi -ExecCmds="TurretAI.Benchmark.Combat 256 64 30 Baseline" -TurretBenchmarkExit
+ * Passing 1 after the name adds the turrets as proxies of the turret proxy subsystem instead of spawning turret actors.
+ *
+ * TurretAI.Benchmark.SkipConverged runs the same benchmark with the converged rotation skip of the turret manager on and then off,
+ * and writes the average game thread time of both runs to the log.
+ */
+UCLASS(Config = Game)
+class TURRETAI_API UTurretBenchmarkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+// Functions
+public:
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/**
+	* Starting the benchmark, does nothing if a benchmark is already running
+	* @param	Duration	Seconds to measure after the warmup
+	* @param	Name		Name of the output files
+	* @param	bProxies	If true, the turrets are added as proxy turrets
+	*/
+	void StartBenchmark(int32 NumTurrets, int32 NumTargets, float Duration, const FString& Name, bool bProxies = false);
+
+	/** Running the benchmark once with the converged rotation skip of the turret manager enabled and once with it disabled */
+	void StartSkipConvergedBenchmark(int32 NumTurrets, int32 NumTargets, float Duration);
+
+	bool IsRunning() const { return bRunning; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void SpawnTurrets(int32 NumTurrets);
+
+	void SpawnTargets(int32 NumTargets);
+
+	void RecordFrame(float DeltaTime);
+
+	/** Writing the results, destroying the spawned actors, and exiting if requested on the command line */
+	void FinishBenchmark();
+
+	void WriteResults() const;
+
+	float GetAverageGameThreadTime() const;
+
+	/** Starting the next run of the converged rotation skip comparison, or writing the comparison to the log after the last run */
+	void StartNextSkipConvergedRun();
+
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+// Variables
+private:
+	/** Turret classes that are spawned in turn, they should have their assets set */
+	UPROPERTY(Config)
+	TArray<FSoftClassPath> TurretClasses;
+
+	/** Distance between the turrets of the grid */
+	UPROPERTY(Config)
+	float TurretSpacing = 1000.0f;
+
+	/** Speed of the targets */
+	UPROPERTY(Config)
+	float TargetSpeed = 400.0f;
+
+	/** Seconds to run before measuring, so the pools are filled and the turrets have found their targets */
+	UPROPERTY(Config)
+	float WarmupTime = 2.0f;
+
+	TArray<TWeakObjectPtr<AActor>> SpawnedActors;
+
+	TArray<FTurretBenchmarkFrame> Frames;
+
+	FString BenchmarkName;
+
+	int32 BenchmarkTurrets = 0;
+	int32 BenchmarkTargets = 0;
+
+	bool bBenchmarkProxies = false;
+
+	float BenchmarkDuration = 0.0f;
+
+	/** Skip states of the comparison that are still to be run, and the average game thread time of the finished runs */
+	TArray<bool> PendingSkipConverged;
+	TArray<TPair<bool, float>> SkipConvergedResults;
+
+	/** Restored when the comparison is done */
+	bool bSkipConvergedBefore = true;
+
+	float WarmupRemaining = 0.0f;
+	float TimeRemaining = 0.0f;
+
+	double GCStartTime = 0.0;
+	double GCTime = 0.0;
+
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+
+	bool bRunning = false;
+};
@@ -0,0 +1,109 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TurretDebrisSubsystem.generated.h"
+
+class ADestroyedStructure;
+
+/**
+ * Debris piece that is in the world
+ */
+USTRUCT()
+struct FTurretDebrisPiece
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<ADestroyedStructure> Piece = nullptr;
+
+	/** World time that the piece is returned to the pool */
+	float ExpireTime = 0.0f;
+
+	/** Falling speed of the non-simulated pieces */
+	float VelocityZ = 0.0f;
+
+	/** Height that the non-simulated pieces stop falling at */
+	float GroundZ = 0.0f;
+
+	uint8 bSimulated : 1;
+	uint8 bSinking : 1;
+
+	FTurretDebrisPiece()
+		: bSimulated(false)
+		, bSinking(false)
+	{
+	}
+};
+
+/**
+ * Spawns the debris of the destroyed turrets from a pool and limits the number of physics simulated pieces.
+ * Pieces over the limit don't have collision, they fall to the ground under a single trace and sink like the simulated ones,
+ * so destroying many turrets at once doesn't spike the physics scene. The subsystem doesn't exist on dedicated servers.
+ */
+UCLASS(Config = Game)
+class TURRETAI_API UTurretDebrisSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+// Functions
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/** Spawning a debris piece with the mesh, the materials and the transform of the component */
+	void SpawnDebris(const UStaticMeshComponent* Source);
+
+	int32 GetNumSimulatedPieces() const { return NumSimulatedPieces; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	ADestroyedStructure* AcquirePiece(const FTransform& Transform);
+
+	void ReleasePiece(int32 Index);
+
+	/** Moving the non-simulated piece down to the ground, then under the ground when it sinks */
+	static void MovePiece(FTurretDebrisPiece& DebrisPiece, float DeltaTime, float GravityZ, float InSinkSpeed);
+
+// Variables
+private:
+	/** Seconds that each piece stays in the world */
+	UPROPERTY(Config)
+	float LifeTime = 6.0f;
+
+	/** Seconds before the end of the life time that the piece starts sinking */
+	UPROPERTY(Config)
+	float SinkDuration = 2.0f;
+
+	/** Sinking speed of the non-simulated pieces */
+	UPROPERTY(Config)
+	float SinkSpeed = 50.0f;
+
+	/** Maximum number of pieces that are simulated at the same time, the rest are moved without physics */
+	UPROPERTY(Config)
+	int32 MaxSimulatedPieces = 24;
+
+	/** Maximum number of inactive pieces, extra pieces are destroyed */
+	UPROPERTY(Config)
+	int32 MaxPoolSize = 64;
+
+	UPROPERTY()
+	TArray<FTurretDebrisPiece> ActivePieces;
+
+	UPROPERTY()
+	TArray<TObjectPtr<ADestroyedStructure>> InactivePieces;
+
+	int32 NumSimulatedPieces = 0;
+};
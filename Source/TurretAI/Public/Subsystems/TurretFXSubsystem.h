@@ -0,0 +1,85 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TurretFXSubsystem.generated.h"
+
+class UNiagaraSystem;
+class USoundBase;
+
+/**
+ * Spawns the cosmetic effects of the turrets and the projectiles. Requests are collected during the frame and spawned together:
+ * effects far from the local players are culled, effects of the same type at the same place are merged into one,
+ * and the nearest effects are spawned up to a budget per frame. The subsystem doesn't exist on dedicated servers.
+ */
+UCLASS(Config = Game)
+class TURRETAI_API UTurretFXSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	struct FFXRequest
+	{
+		TObjectPtr<UNiagaraSystem> System;
+		TObjectPtr<USoundBase> Sound;
+		FVector Location;
+		FRotator Rotation;
+		FVector Scale;
+
+		/** Distance to the closest local view point */
+		float ViewDistanceSquared;
+
+		bool bBudgeted;
+	};
+
+// Functions
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/**
+	* Queuing a particle system and a sound to spawn at the end of the frame, either of them can be null
+	* @param	bBudgeted	If false, the effect is never dropped by the budget, but it is still culled by distance
+	*/
+	void RequestFX(UNiagaraSystem* System, USoundBase* Sound, const FVector& Location, const FRotator& Rotation = FRotator::ZeroRotator,
+		const FVector& Scale = FVector::OneVector, bool bBudgeted = true);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/** Collecting the camera locations of the local players */
+	void UpdateViewLocations();
+
+	void SpawnFX(const FFXRequest& Request) const;
+
+// Variables
+private:
+	/** Effects farther than this distance from every local player are not spawned */
+	UPROPERTY(Config)
+	float CullDistance = 15000.0f;
+
+	/** Requests of the same effects closer than this distance in the same frame are merged */
+	UPROPERTY(Config)
+	float CoalesceDistance = 100.0f;
+
+	/** Maximum number of budgeted effects that are spawned per frame, the farthest ones are dropped */
+	UPROPERTY(Config)
+	int32 MaxSpawnsPerFrame = 24;
+
+	TArray<FFXRequest> Requests;
+
+	TArray<FVector> ViewLocations;
+
+	/** Frame of the collected view locations */
+	uint64 ViewLocationsFrame = MAX_uint64;
+};
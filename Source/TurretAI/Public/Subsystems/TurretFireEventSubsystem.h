@@ -0,0 +1,53 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TurretFireEventSubsystem.generated.h"
+
+class APlayerController;
+class ATurret;
+class ATurretFireEventStream;
+
+/**
+ * Sends the shots of the turrets to the clients through a fire event stream per connection.
+ * Each shot is sent as the turret, a seed and a timestamp, and the clients rebuild the shot from the seed.
+ */
+UCLASS(Config = Game)
+class TURRETAI_API UTurretFireEventSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+// Functions
+public:
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	/** Sending the shot to every remote connection that the turret is relevant to, only called on the server */
+	void AddFireEvent(ATurret* Turret, uint16 Seed);
+
+	float GetMaxEventAge() const { return MaxEventAge; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	ATurretFireEventStream* FindOrAddStream(APlayerController* PlayerController);
+
+	/** Destroying the streams of the players that have left */
+	void RemoveStaleStreams();
+
+// Variables
+private:
+	/** Shots older than this are not sent or played, in seconds */
+	UPROPERTY(Config)
+	float MaxEventAge = 0.5f;
+
+	/** Maximum number of shots that are kept in each stream */
+	UPROPERTY(Config)
+	int32 MaxEventsPerStream = 64;
+
+	TMap<TWeakObjectPtr<APlayerController>, TWeakObjectPtr<ATurretFireEventStream>> Streams;
+};
@@ -0,0 +1,246 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Types/TurretTypes.h"
+#include "TurretManagerSubsystem.generated.h"
+
+class ATurret;
+
+/** Update rate of a turret, based on the distance and direction to the closest player view point */
+enum class ETurretLOD : uint8
+{
+	/** Updated every frame */
+	High,
+	/** Updated every few frames */
+	Medium,
+	/** Updated rarely, idle turrets are not rotated at all */
+	Low,
+
+	Num
+};
+
+/**
+ * Updates the aim of every turret in the world in one batched pass instead of ticking each turret.
+ * Turret state is kept in structure-of-arrays buffers so the rotation pass runs over contiguous memory.
+ * The actors are only read into a snapshot and written back on the game thread, the aim math in between runs in parallel.
+ * Turrets that are far from the players or outside of their view are updated at a lower rate, see ETurretLOD.
+ * Dormant turrets are not updated at all, see ETurretState.
+ */
+UCLASS(Config = Game)
+class TURRETAI_API UTurretManagerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+// Functions
+public:
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/** Adds the turret to the batched update, called by the turret when the game starts */
+	void RegisterTurret(ATurret* Turret);
+
+	/** Removes the turret from the batched update, called by the turret when it ends play */
+	void UnregisterTurret(ATurret* Turret);
+
+	/** Reads the rotation limits and speed of the turret again, called when its archetype is loaded or reloaded */
+	void RefreshTurretInfo(const ATurret* Turret);
+
+	void RefreshTurretInfos();
+
+	/** Adds extra time to the next update of the turret, used by clients to catch up with the server */
+	void AdvanceTurret(const ATurret* Turret, float DeltaTime);
+
+	/**
+	* Reading the aim of the last update of the turret
+	* @param	OutAimLocation	Location of the target, led for non-homing projectiles
+	* @param	bOutAimed		True if the barrel is within the lead aim tolerance of the aim location
+	* @return	False if the turret is not registered, has no target, or the last update was for another target
+	*/
+	bool GetAimResult(const ATurret* Turret, FVector& OutAimLocation, bool& bOutAimed) const;
+
+	int32 GetNumTurrets() const { return Turrets.Num(); }
+
+	int32 GetNumTurretsAtLOD(ETurretLOD LOD) const { return LODCounts[static_cast<int32>(LOD)]; }
+
+	/** Keeps the state of the turret and the number of turrets in each state, called by the turret when its state changes */
+	void SetTurretState(const ATurret* Turret, ETurretState NewState);
+
+	int32 GetNumTurretsInState(ETurretState State) const { return StateCounts[static_cast<int32>(State)]; }
+
+	/** Region wake signal, wakes up the dormant turrets that are inside the sphere */
+	void WakeTurrets(const FVector& Center, float Radius);
+
+	/** Writes the number of turrets in each state, and the number of turrets and the update cost of each LOD since the last call to the log */
+	void LogLODStats();
+
+	/** Measures the aim update of the registered turrets with one task up to one task per worker thread and writes the results to the log */
+	void RunParallelBenchmark(int32 NumIterations);
+
+	bool GetSkipConvergedRotations() const { return bSkipConvergedRotations; }
+
+	/** Used by the combat benchmark to measure the frames with and without the skip */
+	void SetSkipConvergedRotations(bool bSkip) { bSkipConvergedRotations = bSkip; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/** Sets the turret counters of the last frame, the manager ticks once per frame so it publishes them for all turret systems */
+	void PublishStats() const;
+
+	/** Assigns the LOD of each turret from the player view points */
+	void UpdateLODs();
+
+	/** Decides which turrets are updated this frame and how much time has passed for them */
+	void UpdateDeltaTimes(float DeltaTime);
+
+	/** Reads the target and muzzle of each turret, this is the only pass that touches the turret actors before the write back */
+	void GatherTargets();
+
+	/** Number of parallel tasks of the aim update for the current number of turrets */
+	int32 GetNumTasks() const;
+
+	/** Runs the aim update over the turrets split into the number of tasks, one task runs on the game thread only */
+	void UpdateRotations(int32 NumTasks);
+
+	/**
+	* Leads the targets, interpolates the yaw and pitch toward the desired rotation by the delta time of each turret,
+	* and checks the aim for the fire decision. Only reads and writes the arrays of the turrets in the range, safe to run on any thread.
+	*/
+	void UpdateRotationRange(int32 StartIndex, int32 EndIndex);
+
+	/** Writes the rotations that changed back to the turret components, with one transform update per turret */
+	void ApplyRotations();
+
+// Variables
+private:
+	UPROPERTY()
+	TArray<TObjectPtr<ATurret>> Turrets;
+
+	/** Component that rotates around the yaw axis, can be the same as the pitch component */
+	UPROPERTY()
+	TArray<TObjectPtr<USceneComponent>> YawComponents;
+
+	UPROPERTY()
+	TArray<TObjectPtr<USceneComponent>> PitchComponents;
+
+	/** Inverse rotation of each turret actor, turrets are static so this is cached on registration */
+	TArray<FQuat> InvActorRotations;
+
+	/** World location that the barrel rotates around */
+	TArray<FVector> PivotLocations;
+
+	TArray<FVector> TargetLocations;
+	TArray<FVector> TargetVelocities;
+
+	/** Location that the projectiles are fired from */
+	TArray<FVector> MuzzleLocations;
+
+	/** Non-zero when the target should be led, for non-homing projectiles */
+	TArray<uint8> LeadTarget;
+	TArray<float> ProjectileSpeeds;
+	TArray<float> ProjectileGravities;
+
+	/** Led target location of the last update */
+	TArray<FVector> AimLocations;
+
+	/** Target that the aim location of the last update was computed for */
+	TArray<TWeakObjectPtr<const AActor>> AimTargets;
+
+	/** Cosine of the lead aim tolerance of the turret */
+	TArray<float> AimToleranceCosines;
+
+	/** Non-zero when the barrel is within the tolerance of the aim location */
+	TArray<uint8> AimReady;
+
+	/** Non-zero when the turret has a target, otherwise the turret rotates toward its random rotation */
+	TArray<uint8> HasTarget;
+
+	/** Rotation that the turret is rotating toward, either the random rotation or the rotation toward the target */
+	TArray<float> DesiredYaws;
+	TArray<float> DesiredPitches;
+
+	/** Current relative rotation of the turret */
+	TArray<float> Yaws;
+	TArray<float> Pitches;
+
+	/** Axes that moved in the last update, turrets without changes skip the write back */
+	TArray<uint8> RotationChanges;
+
+	TArray<float> RotationSpeeds;
+	TArray<float> MinPitches;
+	TArray<float> MaxPitches;
+
+	/** ETurretLOD of each turret */
+	TArray<uint8> LODs;
+
+	/** ETurretState of each turret */
+	TArray<uint8> States;
+
+	/** Time since the turret was last updated */
+	TArray<float> PendingDeltaTimes;
+
+	/** Time to advance the turret this frame, zero if the turret is skipped */
+	TArray<float> DeltaTimes;
+
+	/** Turrets closer than this distance to a view point use the high LOD */
+	UPROPERTY(Config)
+	float MediumLODDistance = 3000.0f;
+
+	/** Turrets farther than this distance from every view point use the low LOD */
+	UPROPERTY(Config)
+	float LowLODDistance = 8000.0f;
+
+	/** Turrets outside of this half angle of every view point use one LOD lower, in degrees */
+	UPROPERTY(Config)
+	float ViewConeHalfAngle = 60.0f;
+
+	/** Seconds between the LOD updates */
+	UPROPERTY(Config)
+	float LODUpdateInterval = 0.25f;
+
+	/** Number of frames between the updates of a medium LOD turret */
+	UPROPERTY(Config)
+	int32 MediumLODFrameInterval = 2;
+
+	/** Number of frames between the updates of a low LOD turret */
+	UPROPERTY(Config)
+	int32 LowLODFrameInterval = 4;
+
+	/** Runs the aim update on the worker threads, otherwise on the game thread only */
+	UPROPERTY(Config)
+	bool bParallelUpdate = true;
+
+	/** Minimum number of turrets in each parallel task, smaller batches cost more to schedule than to run */
+	UPROPERTY(Config)
+	int32 MinTurretsPerTask = 64;
+
+	/** Skips the write back of the turrets whose rotation has converged, can be disabled to measure the cost it saves */
+	UPROPERTY(Config)
+	bool bSkipConvergedRotations = true;
+
+	float LODUpdateTime = 0.0f;
+
+	uint32 FrameCounter = 0;
+
+	int32 LODCounts[static_cast<int32>(ETurretLOD::Num)] = {};
+
+	int32 StateCounts[static_cast<int32>(ETurretState::Num)] = {};
+
+	/** Number of turret updates and their cost for each LOD since the last stats log */
+	int64 LODUpdateCounts[static_cast<int32>(ETurretLOD::Num)] = {};
+	int64 LODConvergedCounts[static_cast<int32>(ETurretLOD::Num)] = {};
+	uint64 LODCycles[static_cast<int32>(ETurretLOD::Num)] = {};
+
+	uint64 TickCycles = 0;
+	int32 NumStatFrames = 0;
+};
@@ -0,0 +1,246 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Types/TurretAimState.h"
+#include "Types/TurretTypes.h"
+#include "TurretProxySubsystem.generated.h"
+
+class AProjectile;
+class ATurret;
+class ATurretProxyAimStream;
+class UInstancedStaticMeshComponent;
+
+/**
+ * Proxy turrets of a single turret class, the settings are read from the class default object and its archetype
+ */
+USTRUCT()
+struct FTurretProxyGroup
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSubclassOf<ATurret> TurretClass;
+
+	UPROPERTY()
+	TSubclassOf<AProjectile> ProjectileClass;
+
+	/** Draw the parts of all proxies of the group, not created on dedicated servers */
+	UPROPERTY()
+	TObjectPtr<UInstancedStaticMeshComponent> BaseInstances;
+
+	UPROPERTY()
+	TObjectPtr<UInstancedStaticMeshComponent> YawInstances;
+
+	/** Null if the same part rotates around both axes */
+	UPROPERTY()
+	TObjectPtr<UInstancedStaticMeshComponent> PitchInstances;
+
+	FTurretInfo TurretInfo;
+	float DetectionRadius = 0.0f;
+
+	/** False if the same part rotates around both axes, like ATurretV1 */
+	bool bSeparatePitch = false;
+
+	/** The proxies are only simulated when the archetype or the class assets are loaded */
+	bool bAssetsLoaded = false;
+
+	/** Transforms of the parts relative to their parents, the rotations are replaced by the aim */
+	FTransform BaseTransform;
+	FTransform YawTransform;
+	FTransform PitchTransform;
+
+	/** Sockets that the parts are attached to */
+	FTransform YawSocket;
+	FTransform PitchSocket;
+	FTransform MuzzleSocket;
+
+	/** Pivot of the aim relative to the turret */
+	FVector PivotOffset = FVector::ZeroVector;
+
+	// Proxies, stored as structure of arrays
+	TArray<FTransform> Transforms;
+	TArray<FQuat> InvRotations;
+	TArray<float> Yaws;
+	TArray<float> Pitches;
+	TArray<float> Cooldowns;
+	TArray<TWeakObjectPtr<AActor>> Targets;
+	TArray<FVector> TargetLocations;
+
+	/** Turret actor of each promoted proxy */
+	TArray<TWeakObjectPtr<ATurret>> Actors;
+	TArray<uint8> Promoted;
+
+	/** Id of each proxy, given by the server so the clients find the same proxy */
+	TArray<int32> Ids;
+
+	/** Index of the aim of each proxy in the aim stream, only used on the server */
+	TArray<int32> AimIndices;
+
+	/** Set when the target of the proxy has changed and the clients have not been sent the new aim */
+	TArray<uint8> AimChanged;
+
+	/** Parts of each proxy whose instances have to be uploaded */
+	TArray<uint8> DirtyInstances;
+
+	/** Index of each proxy by its id */
+	TMap<int32, int32> IdIndices;
+
+	int32 Num() const { return Transforms.Num(); }
+
+	void RemoveAtSwap(int32 Index);
+};
+
+/**
+ * Lightweight turret backend for large numbers of turrets, simulates turrets as plain data and draws them as instanced meshes.
+ * Targeting and aiming of all proxies run in parallel over a snapshot of the candidates, and firing uses simulated projectiles.
+ * Proxies close to a player are promoted to a full turret actor and demoted again when all players are far away.
+ * Proxies are added and simulated on the server, the clients create them from the replicated stream and only draw them.
+ * The combat benchmark adds its turrets as proxies with TurretAI.Benchmark.Combat [NumTurrets] [NumTargets] [Duration] [Name] 1
+ */
+UCLASS(Config = Game)
+class TURRETAI_API UTurretProxySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+// Functions
+public:
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/**
+	* Adding a proxy turret on the server, the yaw part of the class should be attached to the base mesh and the pitch part to the yaw part
+	* @return	False if the class can't be used as a proxy or this is a client
+	*/
+	bool AddProxy(TSubclassOf<ATurret> TurretClass, const FTransform& Transform);
+
+	/** Removing all proxies and their promoted turret actors on the server */
+	void RemoveAllProxies();
+
+	int32 GetNumProxies() const;
+
+	int32 GetNumPromotedProxies() const;
+
+	/**
+	* Creating a proxy that the server has added, only called on clients
+	* @param	TurretClass	Null if the class isn't loaded on this client, the proxy is skipped then
+	*/
+	void AddReplicatedProxy(int32 ProxyId, TSubclassOf<ATurret> TurretClass, const FTransform& Transform, const FTurretAimState& AimState, ATurret* Turret);
+
+	/**
+	* Applying the aim that the server has sent for a proxy, only called on clients
+	* @param	Turret	Turret actor of the proxy if the server has promoted it and the actor is relevant to this client
+	*/
+	void ApplyProxyAim(int32 ProxyId, const FTurretAimState& AimState, ATurret* Turret);
+
+	/** Removing a proxy that the server has removed, only called on clients */
+	void RemoveProxy(int32 ProxyId);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	FTurretProxyGroup* FindOrAddGroup(TSubclassOf<ATurret> TurretClass);
+
+	/**
+	* Adding the data of a proxy to the group of its class, the proxy is the last one of the group
+	* @return	Null if the class can't be used as a proxy
+	*/
+	FTurretProxyGroup* AddProxyData(TSubclassOf<ATurret> TurretClass, const FTransform& Transform, int32 ProxyId);
+
+	/** Removing the proxy with its aim, the last proxy of the group takes its index */
+	void RemoveProxyAt(FTurretProxyGroup& Group, int32 Index);
+
+	/** Loading the archetype of the group with its bundle, or the class assets when the class doesn't have an archetype */
+	void LoadGroupAssets(int32 GroupIndex);
+
+	void LoadGroupClassAssets(int32 GroupIndex);
+
+	void OnGroupArchetypeLoaded(int32 GroupIndex);
+
+	/** Reading the turret info and the projectile class after they are loaded */
+	void ResolveGroupAssets(int32 GroupIndex);
+
+	/** Finding the targets of the proxies that are due this frame, runs on worker threads */
+	void UpdateTargets(FTurretProxyGroup& Group) const;
+
+	/** Turning the proxies toward their targets, runs on worker threads */
+	void UpdateRotations(FTurretProxyGroup& Group, float DeltaTime) const;
+
+	void FireProxies(FTurretProxyGroup& Group, float DeltaTime) const;
+
+	/** Swapping proxies near the players with turret actors and back */
+	void UpdatePromotions(FTurretProxyGroup& Group, const TArray<FVector, TInlineAllocator<4>>& ViewLocations);
+
+	void Promote(FTurretProxyGroup& Group, int32 Index) const;
+
+	void Demote(FTurretProxyGroup& Group, int32 Index) const;
+
+	/** Sending the current target and rotation of the proxy to the clients */
+	void SendProxyAim(const FTurretProxyGroup& Group, int32 Index) const;
+
+	/** Removing the aim of a removed proxy from the aim stream */
+	void RemoveProxyAim(int32 AimIndex);
+
+	/** Uploading the instances of the proxies that have moved, been promoted or demoted, or all instances when proxies were added or removed */
+	static void UpdateInstances(FTurretProxyGroup& Group);
+
+	/** World transform of the part that rotates around the yaw axis, also the pitch part if there is no separate pitch part */
+	static FTransform GetYawTransform(const FTurretProxyGroup& Group, int32 Index);
+
+	static FTransform GetPitchTransform(const FTurretProxyGroup& Group, int32 Index);
+
+// Variables
+private:
+	/** Proxies closer than this distance to a player are promoted to turret actors */
+	UPROPERTY(Config)
+	float PromoteDistance = 5000.0f;
+
+	/** Promoted turrets farther than this distance from every player are demoted, larger than the promote distance to avoid flickering */
+	UPROPERTY(Config)
+	float DemoteDistance = 6000.0f;
+
+	/** Seconds between the promotion checks */
+	UPROPERTY(Config)
+	float PromotionInterval = 0.5f;
+
+	/** Each proxy searches for a target once every this many frames */
+	UPROPERTY(Config)
+	int32 TargetingFrameInterval = 4;
+
+	/** Proxies fire when the barrel is within this angle of the target in degrees */
+	UPROPERTY(Config)
+	float AimTolerance = 5.0f;
+
+	/** Number of proxies in each parallel task */
+	UPROPERTY(Config)
+	int32 ChunkSize = 256;
+
+	UPROPERTY()
+	TArray<FTurretProxyGroup> Groups;
+
+	/** Owner of the instanced mesh components */
+	UPROPERTY()
+	TObjectPtr<AActor> VisualsActor;
+
+	/** Replicates the aim of the proxies, only spawned on servers */
+	UPROPERTY()
+	TObjectPtr<ATurretProxyAimStream> AimStream;
+
+	/** Index of the group of each proxy by its id, the groups are in a different order on each machine */
+	TMap<int32, int32> ProxyGroupIndices;
+
+	int32 NextProxyId = 0;
+
+	float PromotionTime = 0.0f;
+
+	uint32 FrameCounter = 0;
+};
@@ -0,0 +1,121 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TurretSchedulerSubsystem.generated.h"
+
+class ATurret;
+
+/** Delayed work of a turret that is run by the turret scheduler */
+enum class ETurretTask : uint8
+{
+	/** Searching for a new target, starts the visibility checks */
+	Search,
+	/** Firing at the current target, starts the can hit target check */
+	Fire,
+	/** Switching to a new random rotation */
+	RandomRotation,
+
+	Num
+};
+
+/**
+ * Runs the delayed work of all turrets instead of a timer per turret.
+ * Tasks are bucketed in a timing wheel and run in the order they became due, with a budget per frame for the
+ * expensive tasks, so the cost of the turret AI per frame is bounded. Tasks over the budget run on the next frames.
+ */
+UCLASS(Config = Game)
+class TURRETAI_API UTurretSchedulerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	struct FScheduledTask
+	{
+		TWeakObjectPtr<ATurret> Turret;
+
+		/** Matches the task sequence of the turret unless the task has been canceled or rescheduled */
+		uint32 Sequence = 0;
+
+		/** Number of full wheel turns to wait before the task is due */
+		int32 Rounds = 0;
+
+		ETurretTask Task = ETurretTask::Search;
+	};
+
+// Functions
+public:
+	//~ Begin USubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/**
+	* Scheduling the task of the turret, replaces the pending task of the same type
+	* @param	Delay	Seconds to wait, zero runs the task as soon as the budget allows it
+	*/
+	void Schedule(ATurret* Turret, ETurretTask Task, float Delay);
+
+	void Cancel(ATurret* Turret, ETurretTask Task);
+
+	static bool IsScheduled(const ATurret* Turret, ETurretTask Task);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/** Moving the due tasks of the slot to the ready queues */
+	void ExpireSlot(int32 SlotIndex);
+
+	/** Running the ready tasks of the type in order, up to the budget */
+	void RunReadyTasks(ETurretTask Task, int32 Budget);
+
+	/** Ranking the candidates of the searches of this frame in parallel and starting their visibility checks */
+	void RunSearchBatch();
+
+	static bool IsValidTask(const FScheduledTask& ScheduledTask);
+
+// Variables
+private:
+	/** Duration of each slot of the timing wheel in seconds */
+	UPROPERTY(Config)
+	float SlotDuration = 0.05f;
+
+	/** Number of slots of the timing wheel, longer delays take more turns of the wheel */
+	UPROPERTY(Config)
+	int32 NumSlots = 128;
+
+	/** Maximum number of target searches per frame */
+	UPROPERTY(Config)
+	int32 MaxSearchesPerFrame = 16;
+
+	/** Maximum number of fire checks per frame, each one starts a line of sight sweep */
+	UPROPERTY(Config)
+	int32 MaxFireChecksPerFrame = 64;
+
+	/** Searches of a frame are ranked on the worker threads when there are at least this many of them */
+	UPROPERTY(Config)
+	int32 MinParallelSearches = 8;
+
+	TArray<TArray<FScheduledTask>> Slots;
+
+	/** Due tasks of each type in the order they became due */
+	TArray<FScheduledTask> ReadyTasks[static_cast<int32>(ETurretTask::Num)];
+
+	/** Index of the first task of each ready queue that has not been processed */
+	int32 ReadyHeads[static_cast<int32>(ETurretTask::Num)] = {};
+
+	/** Turrets that have gathered their candidates this frame, ranked in one batch */
+	TArray<ATurret*> SearchBatch;
+
+	int32 CurrentSlot = 0;
+
+	/** Time that has passed since the current slot expired */
+	float SlotTime = 0.0f;
+};
@@ -0,0 +1,109 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "TurretTargetSubsystem.generated.h"
+
+class ATurret;
+
+/**
+ * Shared uniform grid of candidate targets (pawns) that is rebuilt once per frame.
+ * Turrets that use the spatial index detection mode query this grid instead of owning a trigger volume,
+ * so the detection cost scales with the nearby candidates instead of the overlap pairs.
+ */
+UCLASS(Config = Game)
+class TURRETAI_API UTurretTargetSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+// Functions
+public:
+	//~ Begin USubsystem Interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/** Adds the turret to the per-frame detection update, should be called on the server only */
+	void RegisterTurret(ATurret* Turret);
+
+	void UnregisterTurret(ATurret* Turret);
+
+	/** Systems other than the turrets that query the grid, the grid is only rebuilt while it has users */
+	void AddGridUser() { ++NumGridUsers; }
+
+	void RemoveGridUser() { NumGridUsers = FMath::Max(NumGridUsers - 1, 0); }
+
+	/**
+	* Finding all candidates that are inside the sphere
+	* @param	Center		Center of the sphere
+	* @param	Radius		Radius of the sphere, the collision radius of the candidates is added to it
+	* @param	OutTargets	Candidates inside the sphere
+	* @return	Number of candidates inside the sphere
+	*/
+	int32 QueryTargets(const FVector& Center, float Radius, TArray<AActor*>& OutTargets) const;
+
+	/**
+	* Finding the closest candidate inside the sphere, only reads the grid so it can be called from worker threads while the grid is not rebuilt
+	* @param	OutLocation	Location of the candidate when the grid was rebuilt
+	*/
+	AActor* FindClosestTarget(const FVector& Center, float Radius, FVector& OutLocation) const;
+
+	/** Checking the current location of the target against the sphere, the target does not need to be a candidate */
+	static bool IsInRange(const AActor* Target, const FVector& Center, float Radius);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void OnActorSpawned(AActor* Actor);
+
+	void RebuildGrid();
+
+	/** Notifying turrets about targets entering their range or the current target leaving it */
+	void UpdateTurrets();
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	template<typename FunctionType>
+	void ForEachCandidateInRange(const FVector& Center, float Radius, FunctionType Function) const;
+
+// Variables
+private:
+	/** Size of each grid cell, should be close to the common detection radius of the turrets */
+	UPROPERTY(Config)
+	float CellSize = 1000.0f;
+
+	TArray<TWeakObjectPtr<APawn>> Candidates;
+
+	/** Snapshot of the candidates that is taken when the grid is rebuilt */
+	UPROPERTY()
+	TArray<TObjectPtr<AActor>> CandidateActors;
+
+	TArray<FVector> CandidateLocations;
+	TArray<float> CandidateRadii;
+
+	/** Index of the candidates in each cell */
+	TMap<FIntPoint, TArray<int32>> Grid;
+
+	UPROPERTY()
+	TArray<TObjectPtr<ATurret>> Turrets;
+
+	/** Detector location and radius of each turret, turrets are static so these are cached on registration */
+	TArray<FVector> TurretCenters;
+	TArray<float> TurretRadii;
+
+	/** Candidates that were in range of the turret on the last update, only compared and never dereferenced */
+	TArray<TArray<FObjectKey>> LastCandidates;
+
+	int32 NumGridUsers = 0;
+
+	FDelegateHandle ActorSpawnedHandle;
+};
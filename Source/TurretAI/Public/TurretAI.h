@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+TURRETAI_API DECLARE_LOG_CATEGORY_EXTERN(LogTurretAI, Log, All);
+
 class FTurretAIModule : public IModuleInterface
 {
 public:
@@ -0,0 +1,39 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Lead aiming for non-homing projectiles, finds where to aim so the projectile meets a moving target
+ */
+struct TURRETAI_API FTurretAimSolver
+{
+	/**
+	* Finding the location to aim at so a projectile fired from the origin meets the target.
+	* The target is expected to move with a constant velocity, the result is compensated for the gravity drop of the projectile.
+	* @param	Origin				Where the projectile is fired from
+	* @param	TargetLocation		Current location of the target
+	* @param	TargetVelocity		Current velocity of the target
+	* @param	ProjectileSpeed		Initial speed of the projectile
+	* @param	GravityZ			Gravity acceleration of the projectile, negative values pull the projectile down
+	* @param	OutAimLocation		Location that the barrel should point at
+	* @param	OutTimeOfFlight		Time for the projectile to reach the target
+	* @return	False if the projectile can't reach the target, then the aim location is the current target location
+	*/
+	static bool SolveIntercept(const FVector& Origin, const FVector& TargetLocation, const FVector& TargetVelocity, float ProjectileSpeed, float GravityZ,
+		FVector& OutAimLocation, float& OutTimeOfFlight);
+
+	/**
+	* Location of a projectile on its ballistic arc
+	* @param	Velocity	Initial velocity of the projectile
+	* @param	Time		Seconds since the projectile was fired
+	*/
+	static FVector GetArcLocation(const FVector& Origin, const FVector& Velocity, float GravityZ, float Time)
+	{
+		return Origin + Velocity * Time + FVector(0.0f, 0.0f, 0.5f * GravityZ * Time * Time);
+	}
+
+	/** Number of refinement steps for the gravity compensation */
+	static constexpr int32 MaxIterations = 4;
+};
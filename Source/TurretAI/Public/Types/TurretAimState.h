@@ -0,0 +1,63 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TurretAimState.generated.h"
+
+/**
+ * Replicated aim state of a turret, only changes when the turret gains or loses a target.
+ * Clients aim at the target themselves and use the server time to catch up with the server.
+ */
+USTRUCT()
+struct TURRETAI_API FTurretAimState
+{
+	GENERATED_BODY()
+
+	/** Yaw of the turret relative to the actor when the state was written, quantized to 16 bits */
+	UPROPERTY()
+	uint16 Yaw;
+
+	/** Pitch of the turret relative to the actor when the state was written, quantized to 16 bits */
+	UPROPERTY()
+	uint16 Pitch;
+
+	/** Set when the turret has a target, even if the target is not relevant to the client */
+	UPROPERTY()
+	uint8 bHasTarget : 1;
+
+	UPROPERTY()
+	TObjectPtr<AActor> Target;
+
+	/** Server world time when the state was written */
+	UPROPERTY()
+	float ServerTime;
+
+	/** Number of times the turret has lost its target, selects the random stream of the idle sweep */
+	UPROPERTY()
+	uint16 SweepPeriod;
+
+	FTurretAimState()
+		: Yaw(0)
+		, Pitch(0)
+		, bHasTarget(false)
+		, Target(nullptr)
+		, ServerTime(0.0f)
+		, SweepPeriod(0)
+	{}
+
+	FRotator GetRotation() const;
+
+	void SetRotation(float InYaw, float InPitch);
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FTurretAimState> : public TStructOpsTypeTraitsBase2<FTurretAimState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
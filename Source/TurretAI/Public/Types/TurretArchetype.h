@@ -0,0 +1,70 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Types/TurretTypes.h"
+#include "TurretArchetype.generated.h"
+
+class AProjectile;
+class UNiagaraSystem;
+class USoundBase;
+
+/**
+ * Shared configuration of a kind of turret. Turrets reference the archetype instead of copying it, so all instances share one config block.
+ * The tuning values can be overridden in the config files and reloaded at runtime with TurretAI.Archetype.Reload.
+ * Archetypes inside the plugin are registered with the asset manager by the module, projects add their own paths to PrimaryAssetTypesToScan.
+ */
+UCLASS(BlueprintType, Const, Config = Game, PerObjectConfig)
+class TURRETAI_API UTurretArchetype : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+// Functions
+public:
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	/** The serialized values of the asset replace the config values, so the overrides are read again after loading */
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	/** Reading the config overrides of all loaded archetypes and updating the turrets of every world in this process, whatever its net mode */
+	static void ReloadArchetypes(UWorld* World);
+
+// Variables
+public:
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	/** Bundle of the projectile and the effects, loaded with the archetype */
+	static const FName GameBundle;
+
+	UPROPERTY(EditDefaultsOnly, Config, Category = "Turret")
+	FTurretInfo TurretInfo;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turret", meta = (AssetBundles = "Game"))
+	TSoftClassPtr<AProjectile> Projectile;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turret|FX", meta = (AssetBundles = "Game"))
+	TSoftObjectPtr<UNiagaraSystem> FireParticle;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turret|FX", meta = (AssetBundles = "Game"))
+	TSoftObjectPtr<USoundBase> FireSound;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turret|FX", meta = (AssetBundles = "Game"))
+	TSoftObjectPtr<UNiagaraSystem> DestroyParticle;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turret|FX", meta = (AssetBundles = "Game"))
+	TSoftObjectPtr<USoundBase> DestroySound;
+
+	/** Only used by the shotgun turrets */
+	UPROPERTY(EditDefaultsOnly, Config, Category = "Turret|Shotgun", meta = (ClampMin = 1, UIMin = 1))
+	uint8 NumOfShots = 3;
+
+	/** Only used by the shotgun turrets */
+	UPROPERTY(EditDefaultsOnly, Config, Category = "Turret|Shotgun", meta = (ClampMin = 0.0, UIMin = 0.0))
+	float ShotgunSpread = 5.0f;
+};
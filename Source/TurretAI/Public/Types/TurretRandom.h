@@ -0,0 +1,38 @@
+// Copyright 2023 Danial Kamali. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Deterministic random values of the turrets. Every value comes from a stream seeded by the world seed and the turret,
+ * so the server and the clients generate the same values and fights can be replayed with the same seed.
+ */
+struct TURRETAI_API FTurretRandom
+{
+	/**
+	* Seed of the random streams of a turret
+	* @param	World			World of the turret, its map name is part of the seed
+	* @param	TurretName		Name of the turret, stable for the turrets that are placed in the level
+	*/
+	static int32 MakeTurretSeed(const UWorld* World, FName TurretName);
+
+	/**
+	* Stream of the idle sweep rotations
+	* @param	SweepPeriod		Number of times the turret has lost its target, each idle period starts a new sequence
+	*/
+	static FRandomStream MakeSweepStream(int32 TurretSeed, uint16 SweepPeriod);
+
+	/** Next rotation of the idle sweep, relative to the turret */
+	static FRotator MakeSweepRotation(FRandomStream& Stream, float MinPitch, float MaxPitch);
+
+	/** Offset of a projectile from the barrel direction, each axis is in [-Spread, Spread] degrees */
+	static FRotator MakeSpreadOffset(FRandomStream& Stream, float Spread);
+
+	/**
+	* Offsets of all the projectiles of a shot
+	* @param	ShotSeed		Seed of the shot, sent to the clients with the fire event
+	* @param	OutOffsets		One offset for each projectile of the shot
+	*/
+	static void MakeSpreadOffsets(uint16 ShotSeed, float Spread, TArrayView<FRotator> OutOffsets);
+};
@@ -51,3 +51,80 @@ struct TURRETAI_API FTurretInfo
 		return (TurretAbility & static_cast<int32>(Flag)) == static_cast<int32>(Flag);
 	}
 };
+
+/**
+ * How the turret detects targets around it
+ */
+UENUM(BlueprintType)
+enum class ETurretDetectionMode : uint8
+{
+	/** Each turret owns a trigger sphere and reacts to its overlap events */
+	Overlap,
+	/** Turrets query a shared grid of candidate targets that is rebuilt once per frame, no trigger volume is used */
+	SpatialIndex
+};
+
+/**
+ * Activity of a turret, only turrets that have something to do cost CPU
+ */
+UENUM(BlueprintType)
+enum class ETurretState : uint8
+{
+	/** Nothing in range, no scheduled tasks, no rotation updates and no replication until a detection or wake signal */
+	Dormant,
+	/** Lost its target, sweeping for a while before going dormant */
+	IdleSweep,
+	/** Searching for a target or waiting for the visibility checks */
+	Acquiring,
+	/** Aiming and firing at the current target */
+	Engaging,
+	Destroyed,
+
+	Num			UMETA(Hidden)
+};
+
+/**
+ * How the projectiles of the turret are spawned and simulated
+ */
+UENUM(BlueprintType)
+enum class EProjectileBackend : uint8
+{
+	/** Each projectile is a pooled projectile actor */
+	Actor,
+	/** Projectiles are simulated as plain data by the projectile simulation subsystem and drawn as instanced meshes */
+	Simulated
+};
+
+/**
+ * Used in turret class to rank the targets, higher scores are preferred
+ */
+USTRUCT(BlueprintType)
+struct TURRETAI_API FTurretTargetScoring
+{
+	GENERATED_BODY()
+
+	/** Closer targets get a higher score */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Targeting", meta = (ClampMin = 0.0, UIMin = 0.0))
+	float DistanceWeight;
+
+	/** Targets closer to the barrel direction get a higher score */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Targeting", meta = (ClampMin = 0.0, UIMin = 0.0))
+	float AngleWeight;
+
+	/** Targets with lower health get a higher score, only for targets with a health component */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Targeting", meta = (ClampMin = 0.0, UIMin = 0.0))
+	float HealthWeight;
+
+	/** Player controlled targets get a higher score */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Targeting", meta = (ClampMin = 0.0, UIMin = 0.0))
+	float ThreatWeight;
+
+	/** Number of the best scored targets that are checked for visibility on each search */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Targeting", meta = (ClampMin = 1, UIMin = 1))
+	int32 MaxVisibilityChecks;
+
+	// Default constructor
+	FTurretTargetScoring()
+		: DistanceWeight(1.0f), AngleWeight(0.5f), HealthWeight(0.25f), ThreatWeight(1.0f), MaxVisibilityChecks(3)
+	{}
+};